@@ -177,6 +177,12 @@ GAX_ENUM(GaSampleFormat, ga_uint16,
  *
  *  Stores the format (frame rate, sample format, channels) for PCM audio data.
  *
+ *  Frames hold one sample per channel, in WAVE order: front left, front
+ *  right, front centre, LFE, back left, back right, side left, side right.
+ *  (6.1 has a single back centre channel in place of the back pair.)  The
+ *  common layouts are mono, stereo, quad (front and back pairs), 5.1 and 7.1;
+ *  the mixer supports up to 8 channels.
+ *
  *  This object may be used on any thread.
  *
  *  \ingroup GaFormat
@@ -648,6 +654,8 @@ typedef ga_result (*GaCbSampleSource_Seek)(GaSampleSourceContext *context, ga_us
 typedef ga_result (*GaCbSampleSource_Tell)(GaSampleSourceContext *context, ga_usize *frames, ga_usize *total_frames);
 /** \ref ga_sample_source_release */
 typedef void (*GaCbSampleSource_Close)(GaSampleSourceContext *context);
+/** \ref ga_sample_source_skip_silence */
+typedef ga_usize (*GaCbSampleSource_SkipSilence)(GaSampleSourceContext *context, ga_usize num_frames);
 
 /** Specifies the creation of a sample source */
 typedef struct {
@@ -657,6 +665,7 @@ typedef struct {
 	GaCbSampleSource_Seek seek;     // OPTIONAL, must come with tell
 	GaCbSampleSource_Tell tell;     // OPTIONAL
 	GaCbSampleSource_Close close;   // OPTIONAL
+	GaCbSampleSource_SkipSilence skip_silence; // OPTIONAL
 	GaSampleSourceContext *context;
 	GaFormat format;
 	ga_bool threadsafe;
@@ -682,6 +691,21 @@ ga_mustuse GaSampleSource *ga_sample_source_create(const GaSampleSourceCreationM
 ga_shoulduse ga_usize ga_sample_source_read(GaSampleSource *sample_src, void *dst, ga_usize num_frames,
                                             GaCbOnSeek onseek, void *seek_ctx);
 
+/** Moves past frames a sample source knows to be silent, without producing them.
+ *
+ *  Sources that can tell where they're silent (say, gaps in a stream, or a
+ *  synthesizer with no notes on) can spare the mixer from reading and
+ *  mixing those frames.  The frames skipped count as read, for
+ *  ga_sample_source_tell() and the like.
+ *
+ *  \ingroup GaSampleSource
+ *  \param sample_src Sample source to skip within.
+ *  \param num_frames Most frames to skip.
+ *  \return How many frames were skipped; 0 if the next frame isn't known to
+ *          be silent, or the source can't tell.
+ */
+ga_usize ga_sample_source_skip_silence(GaSampleSource *sample_src, ga_usize num_frames);
+
 /** Checks whether a sample source has reached the end of the stream.
  *
  *  \ingroup GaSampleSource
@@ -765,6 +789,21 @@ void ga_sample_source_acquire(GaSampleSource *sample_src);
  */
 void ga_sample_source_release(GaSampleSource *sample_src);
 
+/** Retrieves statistics for the pool sample sources are taken from.
+ *
+ *  This covers the sample source objects themselves, not their contexts.
+ *
+ *  \ingroup GaSampleSource
+ */
+GaPoolStats ga_sample_source_pool_stats(void);
+
+/** Tops up the sample source pool until it has at least num_free.
+ *
+ *  \ingroup GaSampleSource
+ *  \return GA_ERR_SYS_MEM if it couldn't.
+ */
+ga_result ga_sample_source_pool_reserve(ga_usize num_free);
+
 
 /************/
 /*  Memory  */
@@ -993,9 +1032,56 @@ typedef struct GaMixer GaMixer;
  *  \return Newly-created mixer object.
  *  \warning The number of frames must be a power-of-two.
  *  \todo Remove the requirement that the buffer be a power-of-two in size.
+ *  \see ga_mixer_create_ext()
  */
 ga_mustuse GaMixer *ga_mixer_create(GaFormat format, ga_uint32 num_frames);
 
+/** Specifies the creation of a mixer */
+typedef struct {
+	GaFormat format;       // format of the PCM frames produced by the mixer
+	ga_uint32 num_frames;  // number of frames to be mixed at a time (must be a power of two)
+	GaSampleFormat mix_fmt; // OPTIONAL, internal mix bus: GaSampleFormat_S32 (default) or GaSampleFormat_F32
+	ga_float32 max_pitch;   // OPTIONAL, highest pitch any handle will play at (default 4); higher pitches are clamped to it
+	ga_uint32 num_threads;  // OPTIONAL, number of threads to mix on, including the one calling ga_mixer_mix (default 1)
+	ga_uint32 max_voices;   // OPTIONAL, most handles to actually mix at once; the least important (see GaHandleParam_Priority) of the rest are virtual.  0 (default) for no limit
+	ga_float32 virtual_gain; // OPTIONAL, playing handles with a gain below this are virtual (default 0)
+	ga_bool dither;         // OPTIONAL, dither U8 output, and S16 output from the F32 bus (default off)
+	ga_bool limiter;        // OPTIONAL, turn the mix down ahead of peaks instead of clipping them, delaying it by ga_mixer_latency() (default off)
+	ga_float32 limiter_ceiling; // OPTIONAL, level the limiter holds peaks to, relative to full scale (default 1)
+	ga_float32 limiter_release; // OPTIONAL, seconds the limiter takes to bring the gain most of the way back up after a peak (default 0.1)
+} GaMixerCreationMinutiae;
+
+/** Creates a mixer object.
+ *
+ *  The S32 mix bus is s32 wide but normalized to s16 magnitude, so sources
+ *  quieter than one s16 lsb are lost and very loud mixes can wrap.  The F32
+ *  bus is normalized to [-1, 1]; it keeps full precision for quiet sources
+ *  and has ample headroom.  Either way, the mix is clipped only once, when
+ *  it's converted to the output format.
+ *
+ *  With dither, a little high-passed triangular noise is added to each
+ *  sample before it's rounded to the output format.  That trades the
+ *  distortion of quantizing quiet mixes for a faint hiss, pushed up towards
+ *  high frequencies where it's hardest to hear.
+ *
+ *  With the limiter, the mix is turned down just ahead of any peak which
+ *  would go over the ceiling, and back up gradually after, rather than
+ *  being clipped.  It looks ahead a fixed, small number of frames; see
+ *  ga_mixer_latency().
+ *
+ *  A virtual handle keeps its place in its sample source, but isn't decoded
+ *  or mixed: the mixer seeks past the frames it would have played (or reads
+ *  and discards them, if the source can't seek), and picks up where it
+ *  should be once the handle becomes audible again.  Of the handles loud
+ *  enough to play, the ones over max_voices with the lowest priority, then
+ *  gain, are virtualized; among equals, the ones which started playing last.
+ *
+ *  \ingroup GaMixer
+ *  \return Newly-created mixer object, or NULL if creation was unsuccessful
+ *          (e.g. an unsupported mix bus format).
+ */
+ga_mustuse GaMixer *ga_mixer_create_ext(const GaMixerCreationMinutiae *minutiae);
+
 /** Suspends the mixer, preventing it from consuming any of its inputs.  If you
  ** attempt to mix from it in this state, it will produce all zeroes
  *
@@ -1031,6 +1117,48 @@ GaFormat ga_mixer_format(GaMixer *mixer);
  */
 ga_pure ga_uint32 ga_mixer_num_frames(GaMixer *mixer);
 
+/** Retrieves a mixer's frame clock.
+ *
+ *  The clock counts the frames the mixer has produced, starting at 0, and
+ *  advances by ga_mixer_num_frames() with every call to ga_mixer_mix()
+ *  (suspended or not).  It's what ga_handle_play_at() and ga_handle_stop_at()
+ *  are scheduled against.
+ *
+ *  \ingroup GaMixer
+ *  \param mixer Mixer object whose clock should be retrieved.
+ *  \return The frame the next call to ga_mixer_mix() will start at.
+ */
+ga_uint64 ga_mixer_frame(GaMixer *mixer);
+
+/** Retrieves how far behind the mix a mixer's output runs.
+ *
+ *  A frame mixed by one call to ga_mixer_mix() comes out of a later one,
+ *  this many frames on.  That's the limiter's lookahead, or 0 without it.
+ *  Frames given to ga_handle_play_at() and ga_handle_stop_at() are mix
+ *  frames, so they're heard this much later.
+ *
+ *  \ingroup GaMixer
+ *  \param mixer Mixer object whose latency should be retrieved.
+ *  \return The latency in frames.
+ */
+ga_pure ga_uint32 ga_mixer_latency(GaMixer *mixer);
+
+/** Running totals for a mixer; see ga_mixer_stats(). */
+typedef struct {
+	ga_uint64 mixes;      // calls to ga_mixer_mix() that weren't suspended
+	ga_uint64 mix_ns;     // nanoseconds spent in them
+	ga_uint64 convert_ns; // of which, converting the mix to the output format
+	ga_uint64 idle_mixes; // of the mixes, how many had nothing to play, and only wrote silence
+} GaMixerStats;
+
+/** Retrieves how much work a mixer has done since it was created.
+ *
+ *  \ingroup GaMixer
+ *  \param mixer Mixer object whose stats should be retrieved.
+ *  \return The mixer's stats.  Any thread may ask, even mid-mix.
+ */
+GaMixerStats ga_mixer_stats(GaMixer *mixer);
+
 /** Mixes samples from all ready handles into a single output buffer.
  *
  *  The output buffer is generally presented directly to the device queue
@@ -1044,11 +1172,33 @@ ga_pure ga_uint32 ga_mixer_num_frames(GaMixer *mixer);
  */
 void ga_mixer_mix(GaMixer *mixer, void *buffer);
 
+/** Waits until a mixer might have something to play.
+ *
+ *  When the last call to ga_mixer_mix() found nothing playing (so it only
+ *  wrote silence), blocks until a handle is played, or otherwise changed,
+ *  or until ga_mixer_wake() is called.  Otherwise returns straight away.
+ *  Lets a thread feeding a device stop feeding it silence, and sleep.
+ *
+ *  \ingroup GaMixer
+ *  \param mixer Mixer object to wait on.
+ */
+void ga_mixer_wait(GaMixer *mixer);
+
+/** Wakes up a thread waiting in ga_mixer_wait(), if there is one; if not,
+ *  the next call to ga_mixer_wait() returns straight away.
+ *
+ *  \ingroup GaMixer
+ *  \param mixer Mixer object whose waiter should be woken.
+ */
+void ga_mixer_wake(GaMixer *mixer);
+
 /** Dispatches all pending finish callbacks.
  *
  *  This function should be called regularly. This function (like all other functions
  *  associated with this object) must be called from the main thread. All callbacks
- *  will be called on the main thread.
+ *  will be called on the main thread.  Destroyed handles are also cleaned up
+ *  here.  Only handles which have finished or been destroyed since the last
+ *  call are looked at, so it's cheap when nothing has happened.
  *
  *  \ingroup GaMixer
  *  \param mixer Mixer object whose handles' finish callbacks should be dispatched.
@@ -1093,6 +1243,17 @@ void ga_mixer_destroy(GaMixer *mixer);
  */
 typedef struct GaHandle GaHandle;
 
+/** Opaque integer name for a handle.
+ *
+ *  Unlike a GaHandle pointer, an id is safe to hold on to after the handle
+ *  is gone: once the handle has been cleaned up (see ga_mixer_dispatch()),
+ *  ga_handle_lookup() rejects its id, even if another handle has since
+ *  taken its place.  0 is never a valid id.
+ *
+ *  \ingroup GaHandle
+ */
+typedef ga_uint64 GaHandleId;
+
 typedef struct GaHandleGroup GaHandleGroup;
 
 /** Enumerated handle parameter values.
@@ -1104,9 +1265,10 @@ typedef struct GaHandleGroup GaHandleGroup;
  *  \defgroup handleParams Handle Parameters
  */
 typedef enum {
-	GaHandleParam_Pitch,    /**< Pitch/speed multiplier (normal -> 1.0). Floating-point parameter. \ingroup handleParams */
-	GaHandleParam_Pan,      /**< Left <-> right pan (center -> 0.0, left -> -1.0, right -> 1.0). Floating-point parameter. \ingroup handleParams */
+	GaHandleParam_Pitch,    /**< Pitch/speed multiplier (normal -> 1.0, paused -> 0.0; must be finite and not negative); changes glide over one mix. Floating-point parameter. \ingroup handleParams */
+	GaHandleParam_Pan,      /**< Left <-> right pan (center -> 0.0, left -> -1.0, right -> 1.0); mono mixers ignore it. Floating-point parameter. \ingroup handleParams */
 	GaHandleParam_Gain,     /**< Gain/volume (silent -> 0.0, normal -> 1.0). Floating-point parameter. \ingroup handleParams */
+	GaHandleParam_Priority, /**< Importance when there are more handles playing than voices to play them on (normal -> 0; higher wins).  See GaMixerCreationMinutiae::max_voices and ga_handle_group_set_limit().  Integer parameter. \ingroup handleParams */
 } GaHandleParam;
 
 /** Enumerated parameter values for ga_handle_tell().
@@ -1150,6 +1312,22 @@ typedef void (*GaCbHandleFinish)(GaHandle *finished_handle, void *context);
  */
 ga_mustuse GaHandle *ga_handle_create(GaMixer *mixer, GaSampleSource *sample_src, GaHandleGroup *handle_group);
 
+/** Creates a handle for each of num_handles sample sources at once.
+ *
+ *  Equivalent to calling ga_handle_create() on each, but the mixer, the
+ *  group and the mixer's handle lists are only locked once for the lot.
+ *  Either every handle is created, or none is.
+ *
+ *  \ingroup GaHandle
+ *  \param mixer The mixer that should mix the handles' sample data.
+ *  \param sample_srcs The sample sources, one per handle.
+ *  \param num_handles Number of handles to create.
+ *  \param handle_group The handle group to place the new handles in, or null for the mixer's default.
+ *  \param handles Receives the new handles, in the same order as sample_srcs.
+ *  \return GA_ERR_MIS_PARAM if a source can't be mixed; GA_ERR_SYS_MEM if there wasn't room.
+ */
+ga_canuse ga_result ga_handle_create_batch(GaMixer *mixer, GaSampleSource *const *sample_srcs, ga_usize num_handles, GaHandleGroup *handle_group, GaHandle **handles);
+
 
 /******************/
 /*  Handle group  */
@@ -1174,6 +1352,15 @@ ga_mustuse GaHandle *ga_handle_create(GaMixer *mixer, GaSampleSource *sample_src
  */
 ga_mustuse GaHandleGroup *ga_handle_group_create(GaMixer *mixer);
 
+/** Retrieves a mixer's master handle group.
+ *
+ *  Handles created without a group belong to it.  It can't be destroyed,
+ *  or made a submix bus.
+ *
+ *  \ingroup GaHandleGroup
+ */
+GaHandleGroup *ga_mixer_handle_group(GaMixer *mixer);
+
 /** Disowns all handles associated with a handle group.
  *
  *  They will be moved into the mixer's master handlegroup; this is the same as
@@ -1204,10 +1391,112 @@ void ga_handle_group_destroy(GaHandleGroup *group);
  */
 void ga_handle_group_add(GaHandleGroup *group, GaHandle *handle);
 
+/** What to do when a handle starts playing in a group at its limit.
+ *
+ *  \ingroup GaHandleGroup
+ *  \see ga_handle_group_set_limit()
+ */
+typedef enum {
+	GaVoiceSteal_None,           /**< Refuse to play the new handle. */
+	GaVoiceSteal_Oldest,         /**< Finish the handle which has been playing longest. */
+	GaVoiceSteal_Quietest,       /**< Finish the handle with the lowest gain. */
+	GaVoiceSteal_LowestPriority, /**< Finish the handle with the lowest priority, unless the new one's is lower still. */
+} GaVoiceSteal;
+
+/** Limits the number of handles in a group which may play at once.
+ *
+ *  Use a group per sound to cap how many instances of it can overlap.  The
+ *  limit is checked whenever one of the group's handles starts playing: if
+ *  as many are already playing, one of them is finished early (as though its
+ *  sample source had run out) to make room, according to steal, or
+ *  ga_handle_play() fails.  Ties go to whichever started playing first.
+ *
+ *  \ingroup GaHandleGroup
+ *  \param group Group to limit.
+ *  \param max_playing Most handles to play at once, or 0 for no limit (the default).
+ *  \param steal Which handle to finish when the limit is reached.
+ *  \return GA_OK, or GA_ERR_MIS_PARAM for an unknown policy.
+ */
+ga_canuse ga_result ga_handle_group_set_limit(GaHandleGroup *group, ga_uint32 max_playing, GaVoiceSteal steal);
+
+/** Effect callback run on a submix bus.
+ *
+ *  Processes num_frames frames of the bus in place.  The samples are in the
+ *  mixer's mix bus format (format->sample_fmt): either GaSampleFormat_F32,
+ *  nominally in [-1, 1], or GaSampleFormat_S32 at 16-bit magnitude, with
+ *  headroom above.  Called on the mixing thread, so it mustn't block.
+ *
+ *  \ingroup GaHandleGroup
+ *  \see ga_handle_group_set_bus_effect()
+ */
+typedef void (*GaCbBusEffect)(void *context, void *buffer, ga_usize num_frames, const GaFormat *format);
+
+/** Makes a handle group a submix bus.
+ *
+ *  Normally, each handle is mixed straight into the mixer's output.  A bus
+ *  group's handles are mixed into a buffer of the bus's own instead, which
+ *  then gets the bus's gain and effect (see ga_handle_group_set_bus_gain()
+ *  and ga_handle_group_set_bus_effect()) applied once for all of them before
+ *  it's mixed into its parent.  Buses are processed bottom-up, so a parent
+ *  bus hears its children after they're processed.  A bus with nothing
+ *  playing into it this mix is skipped entirely, effect included.
+ *
+ *  Routing a group which is already a bus just changes its parent.
+ *
+ *  \ingroup GaHandleGroup
+ *  \param group Group to turn into a bus.  Not the mixer's master group.
+ *  \param parent Bus (a group already routed) to feed, or null (or the master
+ *         group) for the mixer's output.
+ *  \return GA_OK; GA_ERR_MIS_PARAM if group is the master group, parent isn't
+ *          a bus, or the route would form a loop; GA_ERR_SYS_MEM if the bus's buffers couldn't be allocated.
+ */
+ga_canuse ga_result ga_handle_group_route(GaHandleGroup *group, GaHandleGroup *parent);
+
+/** Stops a handle group being a submix bus.
+ *
+ *  Its handles are mixed straight into the output again, and any buses
+ *  feeding it are rerouted to its parent.  No-op if it isn't a bus.
+ *  Destroying a bus group unroutes it first.
+ *
+ *  \ingroup GaHandleGroup
+ */
+void ga_handle_group_unroute(GaHandleGroup *group);
+
+/** Sets the gain applied to a submix bus (default 1).
+ *
+ *  Unlike the group's GaHandleParam_Gain, which is copied to each handle,
+ *  this scales the bus's mix.  Changes are ramped over one mix.
+ *
+ *  \ingroup GaHandleGroup
+ *  \return GA_OK, or GA_ERR_MIS_RANGE for a negative gain.
+ */
+ga_canuse ga_result ga_handle_group_set_bus_gain(GaHandleGroup *group, ga_float32 gain);
+
+/** Sets the effect run on a submix bus, after its gain.
+ *
+ *  \ingroup GaHandleGroup
+ *  \param effect Effect callback, or null for none (the default).
+ *  \param context Passed to effect.
+ */
+void ga_handle_group_set_bus_effect(GaHandleGroup *group, GaCbBusEffect effect, void *context);
+
 ga_canuse ga_result ga_handle_group_set_paramf(GaHandleGroup *group, GaHandleParam param, ga_float32 value);
 ga_canuse ga_result ga_handle_group_get_paramf(GaHandleGroup *group, GaHandleParam param, ga_float32 *value);
 
 void ga_handle_group_play(GaHandleGroup *group);
+
+/** Plays every handle in a group, starting together at the given frame.
+ *
+ *  As ga_handle_play_at() on each handle, except that the mixer sees all of
+ *  them at once: however it falls relative to a mix running on another
+ *  thread, they start at the same frame.  ga_handle_group_play() is this
+ *  with a frame of 0, starting them all at the start of the next mix.
+ *
+ *  \ingroup GaHandleGroup
+ *  \param group The group to play.
+ *  \param frame Frame to start at, by the mixer's clock (see ga_mixer_frame()).
+ */
+void ga_handle_group_play_at(GaHandleGroup *group, ga_uint64 frame);
 void ga_handle_group_stop(GaHandleGroup *group);
 
 /** Destroys an audio playback handle.
@@ -1224,12 +1513,30 @@ void ga_handle_destroy(GaHandle *handle);
  *
  *  \ingroup GaHandle
  *  \param handle Handle object to play.
- *  \return GA_OK if the handle could be played; GA_ERR_MIS_UNSUP else
+ *  \return GA_OK if the handle could be played; GA_ERR_MIS_UNSUP else (including
+ *          when its group is at its limit, see ga_handle_group_set_limit())
  *  \warning You cannot play a handle that has finished playing. When in doubt, check
  *           ga_handle_finished() to verify this state prior to calling play.
  */
 ga_canuse ga_result ga_handle_play(GaHandle *handle);
 
+/** Starts playback of an audio playback handle at a given mixer frame.
+ *
+ *  The handle starts exactly at that frame of the mixer's output, wherever
+ *  it falls in a mix, rather than at the start of the next one.  A frame
+ *  which has already been mixed starts it at the start of the next mix, as
+ *  ga_handle_play() does.  The handle counts as playing (including for
+ *  group limits) from the call on; one which was already playing holds
+ *  until the new start.  A stop scheduled for no later than the start is
+ *  dropped.
+ *
+ *  \ingroup GaHandle
+ *  \param handle Handle object to play.
+ *  \param frame Frame to start at, by the mixer's clock (see ga_mixer_frame()).
+ *  \return As for ga_handle_play().
+ */
+ga_canuse ga_result ga_handle_play_at(GaHandle *handle, ga_uint64 frame);
+
 /** Stops playback of a playing audio playback handle.
  *
  *  It is valid to call ga_handle_stop() on a handle that is already stopped.
@@ -1242,6 +1549,19 @@ ga_canuse ga_result ga_handle_play(GaHandle *handle);
  */
 ga_canuse ga_result ga_handle_stop(GaHandle *handle);
 
+/** Stops playback of an audio playback handle at a given mixer frame.
+ *
+ *  The handle is mixed up to, but not including, that frame of the
+ *  mixer's output, and then stopped.  Replaces any earlier scheduled stop;
+ *  ga_handle_stop() cancels it.
+ *
+ *  \ingroup GaHandle
+ *  \param handle Handle object to stop.
+ *  \param frame Frame to stop at, by the mixer's clock (see ga_mixer_frame()).
+ *  \return GA_OK, or GA_ERR_MIS_UNSUP if the handle has finished playing.
+ */
+ga_canuse ga_result ga_handle_stop_at(GaHandle *handle, ga_uint64 frame);
+
 /** Checks whether a handle is currently playing.
  *
  *  \ingroup GaHandle
@@ -1395,6 +1715,42 @@ ga_semipure ga_bool ga_handle_ready(GaHandle *handle, ga_usize num_frames);
  */
 GaFormat ga_handle_format(GaHandle *handle);
 
+/** Retrieves a handle's id.
+ *
+ *  \ingroup GaHandle
+ *  \param handle Handle whose id should be retrieved.
+ *  \return The handle's id; see GaHandleId.
+ */
+ga_pure GaHandleId ga_handle_id(GaHandle *handle);
+
+/** Finds the handle with a given id.
+ *
+ *  Takes constant time and no locks.  The handle returned stays valid until
+ *  the next call to ga_mixer_dispatch().
+ *
+ *  \ingroup GaHandle
+ *  \param mixer The mixer the handle was created on.
+ *  \param id The handle's id, from ga_handle_id().
+ *  \return The handle, or null if it has been cleaned up (or the id was never valid).
+ */
+ga_semipure GaHandle *ga_handle_lookup(GaMixer *mixer, GaHandleId id);
+
+/** Retrieves statistics for a mixer's pool of handles.
+ *
+ *  A handle keeps its mutex when it returns to the pool, so a handle from
+ *  the pool is created without allocating at all.
+ *
+ *  \ingroup GaHandle
+ */
+GaPoolStats ga_mixer_handle_pool_stats(GaMixer *mixer);
+
+/** Tops up a mixer's pool of handles until it has at least num_free.
+ *
+ *  \ingroup GaHandle
+ *  \return GA_ERR_SYS_MEM if it couldn't; GA_ERR_MIS_RANGE if the mixer can't have that many handles.
+ */
+ga_result ga_mixer_handle_pool_reserve(GaMixer *mixer, ga_usize num_free);
+
 
 /*****************************/
 /*  Buffered-Stream Manager  */
@@ -1437,6 +1793,29 @@ void ga_stream_manager_buffer(GaStreamManager *mgr);
  */
 void ga_stream_manager_destroy(GaStreamManager *mgr);
 
+/** Renders any number of frames from a mixer, as fast as it can mix them.
+ *
+ *  For rendering offline, say to a file, rather than to a device.  Before
+ *  each of the mixer's blocks is mixed, the streams are filled right there
+ *  on the calling thread, so no stream is ever skipped for not being ready,
+ *  and nothing waits on a background thread or a device.
+ *
+ *  The mixer still mixes whole blocks of ga_mixer_num_frames() frames; what's
+ *  left of the last one is kept and handed out first by the next call.
+ *  Don't also call ga_mixer_mix() on the mixer, and call
+ *  ga_mixer_dispatch() between renders as usual.
+ *
+ *  \ingroup GaMixer
+ *  \param mixer Mixer to render.
+ *  \param streams Manager of the streams played by the mixer's handles, or
+ *                 null if none are.
+ *  \param dst Buffer for num_frames frames in the mixer's format.
+ *  \param num_frames Number of frames to render.
+ *  \return GA_OK, or GA_ERR_SYS_MEM if there was no memory to keep a
+ *          partial block in (in which case nothing was rendered).
+ */
+ga_result ga_mixer_render(GaMixer *mixer, GaStreamManager *streams, void *dst, ga_usize num_frames);
+
 
 /*********************/
 /*  Buffered Stream  */
@@ -1573,12 +1952,54 @@ void ga_stream_release(GaBufferedStream *stream);
 
 typedef struct GaResamplingState GaResamplingState;
 
+// Linear interpolates between neighbouring frames, cheaply, but aliases.
+// The others interpolate through a polyphase windowed-sinc filter, whose
+// length (and cost) doubles at each level.  A filter is built the first
+// time it's needed for a given ratio and quality, then shared, and kept
+// around for later states until ga_trans_resample_trim()
+typedef enum {
+	GaResampleQuality_Linear,
+	GaResampleQuality_Low,
+	GaResampleQuality_Medium,
+	GaResampleQuality_High,
+} GaResampleQuality;
+
+// same as ga_trans_resample_setup_ext(), with GaResampleQuality_Linear
 ga_mustuse GaResamplingState *ga_trans_resample_setup(ga_uint32 drate, GaFormat format);
+ga_mustuse GaResamplingState *ga_trans_resample_setup_ext(ga_uint32 drate, GaFormat format, GaResampleQuality quality);
 void ga_trans_resample_teardown(GaResamplingState *rs);
+// free the cached filters no state is using
+void ga_trans_resample_trim(void);
 // lengths are in frames, not bytes or samples
 void ga_trans_resample_point(GaResamplingState *rs, void *dst, ga_usize dlen, void *src, ga_usize slen);
 void ga_trans_resample_linear(GaResamplingState *rs, void *dst, ga_usize dlen, void *src, ga_usize slen);
+// only for states set up with a quality above GaResampleQuality_Linear
+void ga_trans_resample_sinc(GaResamplingState *rs, void *dst, ga_usize dlen, void *src, ga_usize slen);
+// linear or sinc, by the state's quality
+void ga_trans_resample(GaResamplingState *rs, void *dst, ga_usize dlen, void *src, ga_usize slen);
 ga_pure ga_usize ga_trans_resample_howmany(GaResamplingState *rs, ga_usize out);
+// how many source frames ga_trans_resample()'s output lags behind its input
+ga_pure ga_uint32 ga_trans_resample_latency(GaResamplingState *rs);
+
+/** Create a sound object holding another's data in a different format.
+ *
+ *  The channels are routed as the mixer would route them for a handle at
+ *  gain 1.0 and pan 0.0, and the frame rate is converted with the given
+ *  quality; the result covers the same length of time as the original.
+ *  Converting a sound once to the mixer's format (see ga_mixer_format())
+ *  spares converting it every time it's played: a handle in the mixer's
+ *  format and at pitch 1.0 is mixed straight in.  The returned object has
+ *  an initial reference count of 1; if the sound is already in the given
+ *  format, it's the same object, with another reference acquired.
+ *
+ *  \ingroup GaSound
+ *  \param sound Sound object whose data should be converted.
+ *  \param format Format to convert it to.
+ *  \param quality How to convert the frame rate, if it differs.
+ *  \return Newly-allocated sound object, or NULL if the format isn't
+ *          supported or there wasn't enough memory.
+ */
+ga_mustuse GaSound *ga_sound_convert(GaSound *sound, GaFormat format, GaResampleQuality quality);
 static inline ga_pure ga_uint8 ga_trans_u8_of_s16(ga_sint16 s) {
 	return ((ga_sint32)s + 32768) >> 8;
 }
@@ -16,6 +16,8 @@
 #include "gorilla/ga_system.h"
 #include "gorilla/ga_u_internal.h"
 
+#include <string.h>
+
 /************/
 /*  Device  */
 /************/
@@ -151,6 +153,7 @@ struct GaSampleSource {
 	GaCbSampleSource_Seek seek;   // OPTIONAL
 	GaCbSampleSource_Tell tell;   // OPTIONAL
 	GaCbSampleSource_Close close; // OPTIONAL
+	GaCbSampleSource_SkipSilence skip_silence; // OPTIONAL
 	GaSampleSourceContext *context;
 	GaFormat format;
 	GaDataAccessFlags flags;
@@ -188,38 +191,80 @@ typedef enum {
 	GaHandleState_Destroyed,
 } GaHandleState;
 
-typedef enum {
-	GaXHandleParam_Pitch,
-	GaXHandleParam_Pan,
-	GaXHandleParam_Gain,
-	GaXHandleParam_LastPan,
-	GaXHandleParam_LastGain,
-	GaXHandleParam_Max,
-} GaXHandleParam;
+// most channels a handle or the mixer may have
+#define GAX_MAX_CHANNELS 8
 
 typedef struct {
-	f32 pitch;
-	f32 gain, last_gain;
-	f32 pan, last_pan;
-} JukeboxState;
+	f32 pitch, gain, pan;
+} GaXHandleParams;
+
+// something ga_mixer_dispatch has to deal with; see GaMixer::events
+typedef struct GaXHandleEvent GaXHandleEvent;
+struct GaXHandleEvent {
+	GaXHandleEvent *next;
+	GaHandle *handle;
+};
+
+// bits of GaHandle::done
+enum {
+	GaXHandleDone_Retired = 1, //the mixer's done with it; see gaX_mixer_retire_voices
+	GaXHandleDone_Destroyed = 2, //so is the game; see ga_handle_destroy
+};
 
 struct GaHandle {
 	GaMixer *mixer;
-	GaResamplingState *resample_state; //non-null iff format.sample_rate != mixerformat.sample_rate
+	// place in the mixer's slot map (see GaXHandleSlots); the generation is
+	// bumped each time the slot's handle is cleaned up
+	u32 slot;
+	atomic_u32 generation;
+	u32 next_free; //next slot on the free list, while this one's on it
 	GaCbHandleFinish callback;
 	void *context;
-	GaHandleState state;
-	JukeboxState jukebox; //point either to def_jukebox, or group->jukebox
-	u32 jukebox_stamps[GaXHandleParam_Max];
+	// a GaHandleState.  Changed under 'mutex', from the game side or by the
+	// mixer, but also read without it, by the mixer and the voice limits
+	atomic_u8 state;
+
+	// Parameters are set from the game side without taking any locks: the
+	// new value is stored in 'params', and the handle is pushed onto the
+	// mixer's dirty list (unless it's already there).  The mixer drains the
+	// list at the start of each mix, copying 'params', along with the state,
+	// group and schedule, into the handle's row of its voice table
+	struct {
+		atomic_f32 pitch, gain, pan;
+		atomic_s32 priority;
+	} params;
+	atomic_bool dirty;
+	GaHandle *next_dirty;
+	// Cleaning up.  Once a handle is both retired and destroyed, whichever
+	// came second queues cleanup_event; a retired handle queues
+	// finish_event first, for its callback.  Each is queued at most once per
+	// handle, so they need no other storage.  A cleaned-up handle may still
+	// be on the dirty list, so it waits in the mixer's limbo list (through
+	// next_limbo) until a fresh drain has started and finished since
+	atomic_u8 done;
+	GaXHandleEvent finish_event, cleanup_event;
+	bool finish_dispatched; //dispatch thread only
+	GaHandle *next_limbo;
+	u64 drain_epoch;
+	// row in mixer->voices, or GAX_NO_VOICE once the mixer is done with it
+	atomic_u32 voice;
+
+	// play_stamp orders handles by when they started playing.
+	// virtual_frames counts the source frames a virtual handle (see
+	// gaX_mixer_pick_voices) has skipped but not yet seeked past
+	atomic_u64 play_stamp;
+	atomic_usz virtual_frames;
+
+	// mixer frames to start and stop at; see ga_handle_play_at.  No
+	// scheduled stop is UINT64_MAX
+	atomic_u64 start_frame, stop_frame;
+
 	GaLink dispatch_link;
-	GaLink mix_link;
 	GaMutex mutex;
 	GaSampleSource *sample_src;
 
 	GaHandleGroup *group;
 	GaLink group_link;
-
-	//JukeboxState def_jukebox;
 };
 
 struct GaHandleGroup {
@@ -229,24 +274,366 @@ struct GaHandleGroup {
 
 	GaMutex mutex;
 
-	JukeboxState jukebox;
-	u32 jukebox_stamps[GaXHandleParam_Max];
+	// setting these sets the members' too; new members inherit them
+	GaXHandleParams params;
+
+	// see ga_handle_group_set_limit
+	u32 max_playing;
+	GaVoiceSteal steal;
+
+	// submix bus; see ga_handle_group_route.  Only changed while holding the
+	// mixer's scratch_mutex, so they're stable for the length of a mix
+	bool is_bus;
+	GaHandleGroup *parent; //bus this one feeds, or NULL for the output
+	u32 bus_index; //in mixer->buses
+	GaCbBusEffect effect;
+	void *effect_context;
+	atomic_f32 bus_gain;
+	f32 last_bus_gain; //what the last mix ended on; only the mix thread touches it
+};
+
+/*****************/
+/*  Mix kernels  */
+/*****************/
+/** Accumulates 'frames' frames of src into dst, a mix bus (see
+ *  gaX_mix_scale()), through a src_channels x dst_channels matrix: source
+ *  channel s feeds mixer channel d with gain mat[s*dst_channels + d].  The
+ *  matrix is ramped linearly; frame i uses mat + i*d_mat.  Kernels
+ *  specialized for a channel layout ignore src_channels and dst_channels.
+ */
+typedef void (*GaXCbMixKernel)(void *dst, const void *src, u32 frames, const f32 *mat, const f32 *d_mat, u32 src_channels, u32 dst_channels);
+
+/** Like GaXCbMixKernel, but for a source moving at another rate: output
+ *  frame i is interpolated at source position gaX_resample_pos(pos, step,
+ *  d_step, i), between the frames either side.  The step between frames i
+ *  and i + 1 is step + i*d_step, so it can ramp the way the matrix does.
+ *  src must hold every frame that reaches, up to frame
+ *  floor(gaX_resample_pos(pos, step, d_step, frames - 1)) + 1.
+ */
+typedef void (*GaXCbMixResample)(void *dst, const void *src, u32 frames, f64 pos, f64 step, f64 d_step, const f32 *mat, const f32 *d_mat, u32 src_channels, u32 dst_channels);
+
+// Source position of output frame i (see GaXCbMixResample).  Whoever works
+// out how far a mix reaches must use this, so that it agrees with the
+// kernel to the last bit
+static inline f64 gaX_resample_pos(f64 pos, f64 step, f64 d_step, usz i) {
+	f64 di = i;
+	return pos + di * (step + (di - 1) * d_step / 2);
+}
+
+/** dst[i] += src[i] for n samples of a mix bus; sums partial mixes. */
+typedef void (*GaXCbMixAdd)(void *dst, const void *src, usz n);
+
+/** Converts n samples of a mix bus to an output format, clipping them to its
+ *  range; the only place the mix is clipped.  With noise non-null, U8 and
+ *  S16 output is dithered: sample i gets noise[i + lag] - noise[i] lsbs
+ *  added before it's rounded.  That's triangular dither, high-passed when
+ *  lag is the channel count, so each channel subtracts its previous frame's
+ *  noise; noise must hold n + lag values.  Other formats ignore noise.
+ */
+typedef void (*GaXCbMixConvert)(void *dst, const void *mix, usz n, const f32 *noise, usz lag);
+
+/** Fills noise with n values uniform in [-0.5, 0.5), from GAX_NOISE_LANES
+ *  xorshift generators: value i comes from state[i % GAX_NOISE_LANES].
+ */
+#define GAX_NOISE_LANES 8
+typedef void (*GaXCbMixNoise)(f32 *noise, usz n, u32 *state);
+
+/** Finds the peak of each of 'frames' frames of a mix bus: the largest
+ *  magnitude of any of its channels, relative to full scale.
+ */
+typedef void (*GaXCbMixPeaks)(f32 *peaks, const void *mix, u32 frames, u32 channels);
+
+/** Scales each of 'frames' frames of a mix bus by its own gain. */
+typedef void (*GaXCbMixGain)(void *mix, const f32 *gains, u32 frames, u32 channels);
+
+/** Sums a[i]*b[i] over n values, n a multiple of 4: one output of an FIR
+ *  filter.  The products are summed in 4 lanes, lane i % 4 taking product
+ *  i, and the lanes then summed as (0 + 2) + (1 + 3).
+ */
+typedef f32 (*GaXCbMixDot)(const f32 *a, const f32 *b, u32 n);
+
+/** Interpolates n frames of 1 or 2 channels (by the table index) for the
+ *  linear resampler: frame i lies frac[i]/rate of the way from src frame
+ *  idx[i] to the next, and is s + (next - s)*frac[i]/rate, computed in that
+ *  order, as ga_trans_resample_linear() does.
+ */
+typedef void (*GaXCbMixLerp)(f32 *dst, const f32 *src, const u32 *idx, const f32 *frac, u32 n, f32 rate);
+
+/** (source channels, mixer channels) pairs which get their own kernels; any
+ *  others go through a generic one.  Every kernel set vectorizes the first
+ *  list; the second only gets scalar specializations.  Extra arguments are
+ *  passed through to X.
+ */
+#define GAX_MIX_LAYOUTS_SIMD(X, ...) \
+	X(1, 1, __VA_ARGS__) X(2, 1, __VA_ARGS__) \
+	X(1, 2, __VA_ARGS__) X(2, 2, __VA_ARGS__)
+#define GAX_MIX_LAYOUTS_SCALAR(X, ...) \
+	X(1, 4, __VA_ARGS__) X(2, 4, __VA_ARGS__) X(4, 4, __VA_ARGS__) \
+	X(1, 6, __VA_ARGS__) X(2, 6, __VA_ARGS__) X(6, 6, __VA_ARGS__) X(6, 2, __VA_ARGS__) \
+	X(1, 8, __VA_ARGS__) X(2, 8, __VA_ARGS__) X(8, 8, __VA_ARGS__) X(8, 2, __VA_ARGS__)
+#define GAX_MIX_LAYOUTS(X, ...) GAX_MIX_LAYOUTS_SIMD(X, __VA_ARGS__) GAX_MIX_LAYOUTS_SCALAR(X, __VA_ARGS__)
+
+#define GAX_MIX_LAYOUT_ENUM(s, d, ...) GaXMixLayout_ ## s ## _ ## d,
+enum {
+	GAX_MIX_LAYOUTS(GAX_MIX_LAYOUT_ENUM, _)
+	GaXMixLayout_Generic,
 };
+#undef GAX_MIX_LAYOUT_ENUM
+
+static inline u32 gaX_mix_layout_index(u32 src_channels, u32 dst_channels) {
+#define GAX_MIX_LAYOUT_CASE(s, d, ...) if (src_channels == s && dst_channels == d) return GaXMixLayout_ ## s ## _ ## d;
+	GAX_MIX_LAYOUTS(GAX_MIX_LAYOUT_CASE, _)
+#undef GAX_MIX_LAYOUT_CASE
+	return GaXMixLayout_Generic;
+}
+
+typedef struct {
+	const char *name;
+	GaXCbMixKernel mix[2][4][GaXMixLayout_Generic + 1]; //[gaX_mix_bus_index()][gaX_sample_format_index()][gaX_mix_layout_index()]
+	GaXCbMixResample resample[2][4][GaXMixLayout_Generic + 1]; //likewise
+	GaXCbMixAdd add[2]; //[gaX_mix_bus_index()]
+	GaXCbMixConvert convert[2][4]; //[gaX_mix_bus_index()][gaX_sample_format_index() of the output]
+	GaXCbMixNoise noise;
+	GaXCbMixPeaks peaks[2]; //[gaX_mix_bus_index()]
+	GaXCbMixGain gain[2]; //likewise
+	GaXCbMixDot dot;
+	GaXCbMixLerp lerp[2]; //[channels - 1]
+} GaXMixKernels;
+
+// reference implementation; the vectorized kernels must match it
+extern const GaXMixKernels gaX_mix_kernels_scalar;
+// picks the best kernels supported by the running cpu
+const GaXMixKernels *gaX_mix_kernels_select(void);
+
+static inline u32 gaX_sample_format_index(GaSampleFormat fmt) {
+	switch (fmt) {
+		case GaSampleFormat_U8:  return 0;
+		case GaSampleFormat_S16: return 1;
+		case GaSampleFormat_S32: return 2;
+		case GaSampleFormat_F32: return 3;
+		default: assert(0); return 0;
+	}
+}
+
+/** There are two mix buses:
+ *  - S32: s32 dynamic range normalized to s16 magnitude.  Quiet sources lose
+ *         everything below one s16 lsb, and anything louder than full scale
+ *         wraps once it exceeds s32.
+ *  - F32: normalized to [-1, 1], with plenty of headroom and no loss of
+ *         precision for quiet sources.
+ *  Either way, the result is only clipped once, when it's converted to the
+ *  output format.
+ */
+static inline u32 gaX_mix_bus_index(GaSampleFormat bus) {
+	return bus == GaSampleFormat_F32;
+}
+
+// multiplier taking a raw sample (u8 recentred around 0) to the scale of the given bus
+static inline f32 gaX_mix_scale(GaSampleFormat bus, GaSampleFormat src) {
+	bool f = bus == GaSampleFormat_F32;
+	switch (src) {
+		case GaSampleFormat_U8:  return f ? 1.f / 128   : 256.f;
+		case GaSampleFormat_S16: return f ? 1.f / 32768 : 1.f;
+		case GaSampleFormat_S32: return f ? 1.f / 2147483648.f : 1.f / 65536;
+		case GaSampleFormat_F32: return f ? 1.f : 32768.f;
+		default: assert(0); return 0;
+	}
+}
+
+/** Fills mat (see GaXCbMixKernel) with the gains taking each channel of a
+ *  source to each channel of the mixer.  Channels are in WAVE order (see
+ *  GaFormat); a source is routed onto whichever of the mixer's speakers are
+ *  nearest its own, and mono sources play on the front pair, as they would on
+ *  a stereo mixer.  Pan then balances the left and right speakers against
+ *  each other, and gain scales the lot.
+ */
+void gaX_mix_matrix(f32 *mat, u32 src_channels, u32 dst_channels, f32 gain, f32 pan);
 
 /************/
 /*  Mixer  */
 /************/
+typedef struct {
+	void *src; //the frames read from one handle
+	usz src_size; //bytes
+	// this thread's buffer for each bus (by bus_index) in the current mix, or
+	// NULL if nothing has been mixed into it yet; see gaX_mixer_bus_buffer
+	void **buses;
+} GaXMixScratch;
+
+// gain and pan folded into a (source channels)x(mixer channels) matrix; see gaX_mix_matrix()
+typedef struct {
+	f32 m[GAX_MAX_CHANNELS * GAX_MAX_CHANNELS];
+} GaXMixMatrix;
+
+// A handle which isn't played at the mixer's rate is interpolated between
+// source frames (see GaXCbMixResample).  'history' has the two frames the
+// next mix starts between, and 'phase' is how far past the first one it starts.
+// 'step' is where the last mix's step ended up, for the next to ramp from;
+// 0 when there's nothing to ramp from
+typedef struct {
+	f64 phase;
+	f64 step;
+	bool primed; //history is valid
+	bool silent; //history is known to be silence (see ga_sample_source_skip_silence)
+	u8 history[2 * GAX_MAX_CHANNELS * sizeof(s32)];
+} GaXResampleState;
+
+#define GAX_NO_VOICE UINT32_MAX
+
+/** Everything the mix loop needs to know about each handle, one array per
+ *  field, so a pass over the handles only touches the fields it uses.  Row i
+ *  belongs to handle[i], whose 'voice' is i.  Rows are added by
+ *  ga_handle_create, and swap-removed by ga_mixer_mix once their handles are
+ *  finished; either way only with the mixer's scratch_mutex held.  Only the
+ *  mix thread otherwise touches the table: the game side gets its changes in
+ *  through the dirty list (see gaX_mixer_drain_params).
+ */
+#define GAX_VOICE_FIELDS(X) \
+	X(GaXMixMatrix, matrix) \
+	X(GaXMixMatrix, last_matrix) /* the one the last mix ended on; each mix ramps from it to matrix */ \
+	X(GaXResampleState, resample) \
+	X(u64, start_frame) X(u64, stop_frame) \
+	X(u64, play_stamp) \
+	X(GaHandle*, handle) \
+	X(GaSampleSource*, src) \
+	X(GaHandleGroup*, group) \
+	X(GaFormat, format) \
+	X(f32, pitch) X(f32, gain) X(f32, pan) \
+	X(s32, priority) \
+	X(u32, ranked) /* not per-row; room to rank every row in gaX_mixer_pick_voices */ \
+	X(u8, state) /* a GaHandleState */ \
+	X(bool, is_virtual)
+
+typedef struct {
+#define GAX_VOICE_FIELD(type, name) type *name;
+	GAX_VOICE_FIELDS(GAX_VOICE_FIELD)
+#undef GAX_VOICE_FIELD
+	void *block; //the allocation the arrays are carved out of
+	u32 count, cap;
+} GaXVoiceTable;
+
+/** Handles live in a slot map: pages of GAX_HANDLE_PAGE_SIZE slots, which
+ *  are added as needed (or ahead of time; see ga_mixer_handle_pool_reserve),
+ *  but never moved or freed until the mixer is.  The slots of cleaned-up
+ *  handles go on a free list, keeping their mutexes, and are reused before
+ *  any new page is added.  A GaHandleId is a slot's index in the low 32 bits,
+ *  and its generation in the high 32: once the handle is cleaned up, the
+ *  generation moves on and the id no longer matches.  Since pages are never
+ *  removed, ga_handle_lookup can check an id without taking any locks.
+ */
+#define GAX_HANDLE_PAGE_BITS 8
+#define GAX_HANDLE_PAGE_SIZE (1u << GAX_HANDLE_PAGE_BITS)
+#define GAX_HANDLE_MAX_PAGES 1024
+#define GAX_NO_SLOT UINT32_MAX
+
+typedef struct {
+	GaHandle *pages[GAX_HANDLE_MAX_PAGES];
+	atomic_u32 num_pages; //a page is filled in before it's counted
+	u32 free; //first free slot, or GAX_NO_SLOT
+	GaPoolStats stats;
+	GaMutex mutex; //guards free, stats and adding pages
+} GaXHandleSlots;
+
+typedef struct {
+	GaMixer *mixer;
+	GaThread *thread;
+	GaSemaphore start;
+	bool quit;
+	void *mix_buffer; //this worker's share of the mix, summed into the mixer's afterwards
+	GaXMixScratch scratch;
+	// the voices to mix: 'count' rows, starting at 'first'
+	u32 first, count;
+} GaXMixWorker;
+
+// Lookahead peak limiter for the master bus; see gaX_mixer_limit.  All of
+// it lives in the one allocation, made with the mixer
+#define GAX_LIMITER_LOOKAHEAD 64
+typedef struct {
+	f32 ceiling; //relative to full scale
+	f32 release; //fraction of the way the gain recovers each frame
+	// the last GAX_LIMITER_LOOKAHEAD frames of mix, still to go out, then room for one more mix
+	void *delay;
+	f32 *peaks, *gains; //one per frame of a mix
+	// sliding minimum of the gain each frame needs, over the lookahead:
+	// a ring of (gain, frame) pairs, gains increasing from min_head
+	f32 *min_gain;
+	u32 *min_frame;
+	u32 min_head, min_count;
+	// the last GAX_LIMITER_LOOKAHEAD+1 held gains, which are averaged to smooth the attack
+	f32 *held;
+	u32 held_pos;
+	u32 frame; //frames seen, mod 2³²
+} GaXLimiter;
+
 struct GaMixer {
+	const GaXMixKernels *kernels;
 	GaFormat format;
 	GaFormat mix_format;
 	u32 num_frames;
-	s32 *mix_buffer;
+	f32 max_pitch;
+	void *mix_buffer; //see gaX_mix_bus_index()
+	// per-handle working buffers for gaX_mixer_mix_voice, sized so the mix
+	// path never has to allocate.  They only grow, and only outside of
+	// ga_mixer_mix, which holds scratch_mutex while it uses them
+	GaXMixScratch scratch;
+	GaMutex scratch_mutex;
+	// parallel mixing: handles are split between the thread calling
+	// ga_mixer_mix and num_workers others; see gaX_mixer_mix_parallel
+	u32 num_workers;
+	GaXMixWorker *workers;
+	GaSemaphore workers_done;
+	GaXHandleSlots handles;
+	// every live handle, for ga_mixer_destroy
 	GaLink dispatch_list;
 	GaMutex dispatch_mutex;
-	GaLink mix_list;
-	GaMutex mix_mutex;
+	// Handles ga_mixer_dispatch has to look at, pushed from any thread and
+	// popped all at once by dispatch, so it never walks the handles that
+	// haven't changed.  limbo is only touched by dispatch
+	GaXHandleEvent *_Atomic events;
+	GaHandle *limbo;
+	GaXVoiceTable voices; //guarded by scratch_mutex
 	GaHandleGroup handle_group;
 	atomic_bool suspended;
+	// handles with parameter changes the mixer hasn't seen yet (linked through next_dirty)
+	GaHandle *_Atomic dirty_handles;
+	atomic_u64 drains; //number of times the dirty list has been drained
+	// batches of changes in progress, which hold off draining; whether a
+	// drain is under way; and whether the last one was put off by a hold
+	// (see gaX_mixer_hold)
+	atomic_u32 holds;
+	atomic_bool draining, held_off;
+	atomic_u64 clock; //first frame of the next mix; see ga_mixer_frame
+	// voice limiting; see gaX_mixer_pick_voices
+	u32 max_voices;
+	f32 virtual_gain;
+	atomic_u64 plays; //source of play_stamps
+	// submix buses, deepest first, so each is done before its parent (see
+	// gaX_mixer_mix_buses).  Bus buffers come from bus_pool, which has one
+	// for every bus on every thread: taking one (bus_pool_next) in the mix
+	// never fails or allocates.  Guarded by scratch_mutex
+	GaHandleGroup **buses;
+	u32 num_buses, buses_cap;
+	void *bus_pool;
+	atomic_u32 bus_pool_next;
+	// dither for gaX_mixer_convert: the last frame's noise, then this one's
+	// (see GaXCbMixConvert).  Null without dither
+	f32 *noise;
+	u32 noise_state[GAX_NOISE_LANES];
+	GaXLimiter *limiter; //null without one
+	// see ga_mixer_stats
+	atomic_u64 stat_mixes, stat_mix_ns, stat_convert_ns, stat_idle_mixes;
+	// Idling (see ga_mixer_wait).  quiet_frames counts the frames mixed since
+	// anything last played; once it covers the latency, the mixer has nothing
+	// left to say, and idle is set.  Whoever posts to dirty_handles wakes a
+	// waiter on 'wake', if 'waiting' says there is one
+	u64 quiet_frames;
+	atomic_bool idle;
+	atomic_bool waiting;
+	GaSemaphore wake;
+	// ga_mixer_render: the mix of the last partial block, of which
+	// render_left frames are still to be handed out
+	void *render_buffer;
+	u32 render_left;
 };
 
 
@@ -325,4 +712,21 @@ static inline s32 ga_add32_saturate(s32 x, s32 y) {
 
 char *gaX_strdup(const char *s);
 
+// fill frames of buf with silence, which for unsigned samples isn't zero
+static inline void gaX_silence(void *buf, usz frames, GaFormat fmt) {
+	memset(buf, fmt.sample_fmt == GaSampleFormat_U8 ? 128 : 0, frames * ga_format_frame_size(fmt));
+}
+
+// monotonic time, for stats
+u64 gaX_time_ns(void);
+
+// with GA_CHECK_RT_ALLOC, ga_alloc and friends assert between these
+#ifdef GA_CHECK_RT_ALLOC
+void gaX_realtime_enter(void);
+void gaX_realtime_leave(void);
+#else
+static inline void gaX_realtime_enter(void) {}
+static inline void gaX_realtime_leave(void) {}
+#endif
+
 #endif //GORILLA_GA_INTERNAL_H
@@ -71,6 +71,33 @@ ga_result ga_initialize_systemops(GaSystemOps *callbacks);
 ga_result ga_shutdown_systemops(void);
 
 
+/**********/
+/*  Pool  */
+/**********/
+/** Object pools.
+ *
+ *  Objects which are created and destroyed in large numbers (handles, sample
+ *  sources, and so on) are recycled through freelists instead of going back
+ *  to the allocator.  Pools only grow.  Each can be topped up ahead of time,
+ *  off the audio thread, so that creating objects later doesn't allocate;
+ *  their statistics tell how far.
+ *
+ *  \ingroup system
+ *  \defgroup GaPool Pools
+ */
+
+/** Usage statistics for an object pool [\ref POD].
+ *
+ *  \ingroup GaPool
+ */
+typedef struct {
+	ga_usize free;   /**< Objects ready to be handed out. */
+	ga_usize in_use; /**< Objects handed out and not yet returned. */
+	ga_usize peak;   /**< Most objects ever in use at once. */
+	ga_usize misses; /**< Times an object was wanted with none free, so one had to be allocated on the spot. */
+} GaPoolStats;
+
+
 /************/
 /*  Thread  */
 /************/
@@ -209,6 +236,49 @@ void ga_mutex_unlock(GaMutex mutex);
  */
 void ga_mutex_destroy(GaMutex mutex);
 
+/***************/
+/*  Semaphore  */
+/***************/
+/** Counting semaphore data structure and associated functions.
+ *
+ *  \ingroup system
+ *  \defgroup GaSemaphore Semaphore
+ */
+
+/** Counting semaphore thread synchronization primitive data structure [\ref MULTI_CLIENT].
+ *
+ *  \ingroup GaSemaphore
+ */
+typedef struct {
+	void *sem;
+} GaSemaphore;
+
+/** Creates a semaphore with the specified initial count.
+ *
+ *  \ingroup GaSemaphore
+ */
+ga_result ga_semaphore_create(GaSemaphore *res, ga_uint32 count);
+
+/** Waits until the semaphore's count is nonzero, then decrements it.
+ *
+ *  \ingroup GaSemaphore
+ */
+void ga_semaphore_wait(GaSemaphore sem);
+
+/** Increments the semaphore's count, waking up one waiter (if any).
+ *
+ *  \ingroup GaSemaphore
+ */
+void ga_semaphore_post(GaSemaphore sem);
+
+/** Destroys a semaphore.
+ *
+ *  \ingroup GaSemaphore
+ *  \warning Make sure nothing is waiting on the semaphore before destroying it.
+ *  \warning Never use a semaphore after it has been destroyed.
+ */
+void ga_semaphore_destroy(GaSemaphore sem);
+
 #ifdef __cplusplus
 } //extern "C"
 #endif
@@ -31,10 +31,12 @@ typedef struct {
 } RC; //refcount
 typedef _Atomic bool atomic_bool;
 typedef _Atomic u8  atomic_u8;
+typedef _Atomic s32 atomic_s32;
 typedef _Atomic u32 atomic_u32;
 typedef _Atomic u64 atomic_u64;
 typedef _Atomic usz atomic_usz;
 typedef _Atomic ssz atomic_ssz;
+typedef _Atomic f32 atomic_f32;
 
 static inline ga_bool decref(RC *count) {
 	_Atomic u32 old = atomic_fetch_add(&count->rc, -1);
@@ -47,10 +49,58 @@ static inline void incref(RC *count) {
 static inline RC rc_new(void) {
 	return (RC){1};
 }
+
+/** Freelist of objects of one size; see GaPool.  New objects are zeroed and
+ *  passed to 'init' (if any) when they're allocated; after that they come
+ *  out as they were put back, so anything expensive to set up (a mutex,
+ *  say) can stay set up while it's pooled.  Safe to use from any thread;
+ *  the lock is only held to push or pop.
+ */
+typedef struct {
+	usz size;
+	ga_result (*init)(void *obj);
+	atomic_flag lock;
+	void *free; //first free object's header; see gaX_pool_get
+	GaPoolStats stats;
+} GaXPool;
+#define GAX_POOL_INIT(type, init_fn) {.size = sizeof(type), .init = (init_fn), .lock = ATOMIC_FLAG_INIT}
+
+void *gaX_pool_get(GaXPool *pool);
+void gaX_pool_put(GaXPool *pool, void *obj);
+ga_result gaX_pool_reserve(GaXPool *pool, usz num_free);
+GaPoolStats gaX_pool_stats(GaXPool *pool);
 #else
 typedef struct { volatile u32 rc; } RC;
 #endif
 
+// Vorbis (and Opus, which borrows its mapping) puts the centre channel
+// between the front pair and LFE last, unlike the WAVE order everyone else
+// uses (see GaFormat).  Gives the Vorbis channel which belongs at position i
+// of a frame with num_channels channels
+static inline u32 vorbis_channel_index(u32 num_channels, u32 i) {
+	static const u8 order[8][8] = {
+		{0},
+		{0, 1},
+		{0, 2, 1},
+		{0, 1, 2, 3},
+		{0, 2, 1, 3, 4},
+		{0, 2, 1, 5, 3, 4},
+		{0, 2, 1, 6, 5, 3, 4},
+		{0, 2, 1, 7, 5, 6, 3, 4},
+	};
+	return num_channels <= 8 ? order[num_channels - 1][i] : i;
+}
+
+// reorder interleaved Vorbis frames in place; see vorbis_channel_index()
+static inline void vorbis_reorder_channels(f32 *samples, usz num_frames, u32 num_channels) {
+	if (num_channels < 3 || num_channels > 8) return;
+	for (usz f = 0; f < num_frames; f++, samples += num_channels) {
+		f32 frame[8];
+		for (u32 i = 0; i < num_channels; i++) frame[i] = samples[vorbis_channel_index(num_channels, i)];
+		for (u32 i = 0; i < num_channels; i++) samples[i] = frame[i];
+	}
+}
+
 #define with_mutex(m) for (bool done = (ga_mutex_lock(m),false); !done; ga_mutex_unlock(m),done=true)
 
 #define min(x, y) ((x) < (y) ? (x) : (y))
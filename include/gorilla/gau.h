@@ -173,6 +173,23 @@ GaSampleSource *gau_sample_source_create_buffered(GaStreamManager *in_mgr, GaSam
  */
 GaSampleSource *gau_sample_source_create_sound(GaSound *in_sound);
 
+/** Retrieves statistics for the pool of sound sample source contexts.
+ *
+ *  A context keeps its mutex while it's in the pool.  Together with
+ *  ga_sample_source_pool_stats() and ga_mixer_handle_pool_stats(), this
+ *  covers everything a one-shot sound handle needs.
+ *
+ *  \ingroup concreteSample
+ */
+GaPoolStats gau_sound_pool_stats(void);
+
+/** Tops up the pool of sound sample source contexts until it has at least num_free.
+ *
+ *  \ingroup concreteSample
+ *  \return GA_ERR_SYS_MEM if it couldn't.
+ */
+ga_result gau_sound_pool_reserve(ga_usize num_free);
+
 /** Creates a sample source of PCM samples from a stream.
  *
  *  \ingroup concreteSample
@@ -280,6 +297,15 @@ typedef enum {
  */
 GaSound *gau_load_sound_file(const char *in_filename, GauAudioType in_format);
 
+/** Load a file's PCM data into a sound object, converted to a given format.
+ *
+ *  The frame rate is converted with GaResampleQuality_High; see
+ *  ga_sound_convert().  Pass the mixer's format for sounds played often.
+ *
+ *  \ingroup loadHelper
+ */
+GaSound *gau_load_sound_file_ext(const char *in_filename, GauAudioType in_format, GaFormat to);
+
 
 /**********************/
 /**  Create Helpers  **/
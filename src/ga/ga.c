@@ -4,14 +4,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 #include <assert.h>
 #include <stdatomic.h>
 
-static u32 autoincrement(void) {
-	static atomic_u32 ret;
-	return atomic_fetch_add(&ret, 1);
-}
-
 /* Version Functions */
 bool ga_version_compatible(s32 major, s32 minor, s32 rev) {
 	return major == GA_VERSION_MAJOR
@@ -267,9 +263,11 @@ void ga_data_source_release(GaDataSource *dataSrc) {
 }
 
 /* Sample Source Structure */
+static GaXPool gaX_sample_source_pool = GAX_POOL_INIT(GaSampleSource, NULL);
+
 GaSampleSource *ga_sample_source_create(const GaSampleSourceCreationMinutiae *m) {
 	if (!m->read || !m->end) return NULL;
-	GaSampleSource *ret = ga_alloc(sizeof(GaSampleSource));
+	GaSampleSource *ret = gaX_pool_get(&gaX_sample_source_pool);
 	if (!ret) return NULL;
 	ret->refCount = rc_new();
 	ret->read = m->read;
@@ -278,6 +276,7 @@ GaSampleSource *ga_sample_source_create(const GaSampleSourceCreationMinutiae *m)
 	ret->seek = m->seek;
 	ret->tell = m->tell;
 	ret->close = m->close;
+	ret->skip_silence = m->skip_silence;
 	ret->context = m->context;
 	ret->format = m->format;
 	ret->flags = (m->seek ? GaDataAccessFlag_Seekable : 0)
@@ -294,6 +293,9 @@ bool ga_sample_source_end(GaSampleSource *src) {
 bool ga_sample_source_ready(GaSampleSource *src, usz num_frames) {
 	return src->ready ? src->ready(src->context, num_frames) : true;
 }
+usz ga_sample_source_skip_silence(GaSampleSource *src, usz num_frames) {
+	return src->skip_silence ? src->skip_silence(src->context, num_frames) : 0;
+}
 ga_result ga_sample_source_seek(GaSampleSource *src, usz sampleOffset) {
 	return src->seek && (src->flags & GaDataAccessFlag_Seekable) ? src->seek(src->context, sampleOffset) : GA_ERR_MIS_UNSUP;
 }
@@ -302,7 +304,15 @@ ga_result ga_sample_source_tell(GaSampleSource *src, usz *frames, usz *total_fra
 }
 static void gaX_sample_source_destroy(GaSampleSource *src) {
 	if (src->close) src->close(src->context);
-	ga_free(src);
+	gaX_pool_put(&gaX_sample_source_pool, src);
+}
+
+GaPoolStats ga_sample_source_pool_stats(void) {
+	return gaX_pool_stats(&gaX_sample_source_pool);
+}
+
+ga_result ga_sample_source_pool_reserve(usz num_free) {
+	return gaX_pool_reserve(&gaX_sample_source_pool, num_free);
 }
 
 GaDataAccessFlags ga_sample_source_flags(GaSampleSource *src) {
@@ -467,6 +477,96 @@ GaSound *ga_sound_create_sample_source(GaSampleSource *src) {
 	}
 }
 
+// one sample of any format, to or from f32
+static f32 gaX_sample_load(const void *src, usz k, GaSampleFormat fmt) {
+	switch (fmt) {
+		case GaSampleFormat_U8:  return ga_trans_f32_of_u8(((const u8*)src)[k]);
+		case GaSampleFormat_S16: return ga_trans_f32_of_s16(((const s16*)src)[k]);
+		case GaSampleFormat_S32: return ga_trans_f32_of_s32(((const s32*)src)[k]);
+		case GaSampleFormat_F32: return ((const f32*)src)[k];
+		default: assert(0); return 0;
+	}
+}
+static void gaX_sample_store(void *dst, usz k, GaSampleFormat fmt, f32 x) {
+	switch (fmt) {
+		case GaSampleFormat_U8:  ((u8*)dst)[k] = ga_trans_u8_of_f32(clamp(x, -1.f, 1.f)); break;
+		case GaSampleFormat_S16: ((s16*)dst)[k] = ga_trans_s16_of_f32(clamp(x, -1.f, 1.f)); break;
+		case GaSampleFormat_S32: ((s32*)dst)[k] = ga_trans_s32_of_f32(clamp(x, -1.f, 0x7fffff80 / 2147483648.f)); break;
+		case GaSampleFormat_F32: ((f32*)dst)[k] = x; break;
+		default: assert(0);
+	}
+}
+
+GaSound *ga_sound_convert(GaSound *sound, GaFormat format, GaResampleQuality quality) {
+	GaFormat from = sound->format;
+	if (!ga_format_sane(format) || !format.frame_rate || format.num_channels > GAX_MAX_CHANNELS || from.num_channels > GAX_MAX_CHANNELS) return NULL;
+	if (quality > GaResampleQuality_High) return NULL;
+	if (from.frame_rate == format.frame_rate && from.num_channels == format.num_channels && from.sample_fmt == format.sample_fmt) {
+		ga_sound_acquire(sound);
+		return sound;
+	}
+
+	// Channels first, as the mixer would route them at gain 1 and pan 0, into
+	// f32 at the sound's own rate; then the rate; then the sample format
+	u32 nsrc = from.num_channels, ndst = format.num_channels;
+	f32 mat[GAX_MAX_CHANNELS * GAX_MAX_CHANNELS];
+	gaX_mix_matrix(mat, nsrc, ndst, 1, 0);
+
+	usz n = sound->num_frames, in = n, out = n, lead = 0;
+	GaResamplingState *rs = NULL;
+	if (from.frame_rate != format.frame_rate) {
+		rs = ga_trans_resample_setup_ext(format.frame_rate, (GaFormat){.frame_rate = from.frame_rate, .num_channels = ndst, .sample_fmt = GaSampleFormat_F32}, quality);
+		if (!rs) return NULL;
+		// The resampler's output lags its input, so the outputs from before
+		// the sound starts are dropped, and silence after it runs through to
+		// bring out the rest.  What's left covers the same length of time
+		lead = ((u64)ga_trans_resample_latency(rs) * format.frame_rate + from.frame_rate / 2) / from.frame_rate;
+		out = ((u64)n * format.frame_rate + from.frame_rate - 1) / from.frame_rate;
+		in = max(n, ga_trans_resample_howmany(rs, lead + out));
+	}
+
+	f32 *mixed = ga_zalloc(in * ndst * sizeof(f32));
+	if (!mixed) goto fail;
+	const void *data = ga_sound_data(sound);
+	for (usz i = 0; i < n; i++) {
+		for (u32 d = 0; d < ndst; d++) {
+			f32 x = 0;
+			for (u32 s = 0; s < nsrc; s++) x += gaX_sample_load(data, i * nsrc + s, from.sample_fmt) * mat[s * ndst + d];
+			mixed[i * ndst + d] = x;
+		}
+	}
+
+	if (rs) {
+		f32 *resampled = ga_alloc((lead + out) * ndst * sizeof(f32));
+		if (!resampled) goto fail;
+		ga_trans_resample(rs, resampled, lead + out, mixed, in);
+		ga_trans_resample_teardown(rs);
+		rs = NULL;
+		ga_free(mixed);
+		mixed = resampled;
+	}
+
+	usz size = out * ga_format_frame_size(format);
+	void *converted = ga_alloc(size);
+	if (!converted) goto fail;
+	for (usz k = 0; k < out * ndst; k++) gaX_sample_store(converted, k, format.sample_fmt, mixed[lead * ndst + k]);
+	ga_free(mixed);
+
+	GaMemory *memory = gaX_memory_create(converted, size, false);
+	if (!memory) {
+		ga_free(converted);
+		return NULL;
+	}
+	GaSound *ret = ga_sound_create(memory, format);
+	ga_memory_release(memory);
+	return ret;
+
+fail:
+	if (rs) ga_trans_resample_teardown(rs);
+	ga_free(mixed);
+	return NULL;
+}
+
 const void *ga_sound_data(GaSound *sound) {
 	return ga_memory_data(sound->memory);
 }
@@ -496,50 +596,398 @@ void ga_sound_release(GaSound *sound) {
 	if (decref(&sound->refCount)) gaX_sound_destroy(sound);
 }
 
-static void init_jukeboxstate(JukeboxState *state) {
-	state->pitch = 1;
-	state->gain = state->last_gain = 1;
-	state->pan =  state->last_pan = 0;
+// queue an event for ga_mixer_dispatch.  Lock-free; callable from any thread
+static void gaX_mixer_push_event(GaMixer *m, GaXHandleEvent *ev) {
+	GaXHandleEvent *head = atomic_load(&m->events);
+	do ev->next = head;
+	while (!atomic_compare_exchange_weak(&m->events, &head, ev));
+}
+
+// push the handles first..last, already linked through next_dirty, onto the
+// mixer's dirty list in one go
+static void gaX_mixer_post_chain(GaMixer *m, GaHandle *first, GaHandle *last) {
+	GaHandle *head = atomic_load(&m->dirty_handles);
+	do last->next_dirty = head;
+	while (!atomic_compare_exchange_weak(&m->dirty_handles, &head, first));
+}
+
+// queue the handle for the mixer to pick up its parameters.  Lock-free;
+// callable from any number of threads at once
+static void gaX_handle_post(GaHandle *h) {
+	// already queued?  Then the mixer will see the new values anyway
+	if (atomic_exchange(&h->dirty, true)) return;
+
+	GaMixer *m = h->mixer;
+	gaX_mixer_post_chain(m, h, h);
+	if (atomic_load(&m->waiting)) ga_mixer_wake(m);
+}
+
+static void gaX_mixer_drain_params(GaMixer *m);
+
+// Keep the mixer from draining the dirty list until gaX_mixer_release, so a
+// batch of changes is picked up by one mix.  The mixer doesn't wait for the
+// hold: it just drains a mix later.  A hold lasts as long as one batch, and
+// once a drain has been put off, no new hold starts until a drain has
+// happened (here, if the mixer hasn't got to it), so holds overlapping from
+// several threads can't keep the mixer from draining for good.  Otherwise
+// this only waits out a drain that had already started before the hold was
+// seen
+static void gaX_mixer_hold(GaMixer *m) {
+	while (atomic_load(&m->held_off)) {
+		if (atomic_load(&m->holds)) ga_thread_yield();
+		else with_mutex(m->scratch_mutex) gaX_mixer_drain_params(m);
+	}
+	atomic_fetch_add(&m->holds, 1);
+	while (atomic_load(&m->draining)) ga_thread_yield();
+}
+
+// post the handles first..last (if any), linked through next_dirty with
+// their dirty flags set, and let go of the hold
+static void gaX_mixer_release(GaMixer *m, GaHandle *first, GaHandle *last) {
+	if (first) gaX_mixer_post_chain(m, first, last);
+	atomic_fetch_sub(&m->holds, 1);
+	if (atomic_load(&m->waiting)) ga_mixer_wake(m);
+}
+
+static void gaX_handle_set_params(GaHandle *h, const GaXHandleParams *params) {
+	atomic_store(&h->params.pitch, params->pitch);
+	atomic_store(&h->params.gain, params->gain);
+	atomic_store(&h->params.pan, params->pan);
+	gaX_handle_post(h);
+}
+
+// most source frames one mix can read from a handle of the given format:
+// however far it moves at the highest pitch, plus the two frames either
+// side of where it ends up (see gaX_mixer_mix_voice_frames)
+static usz gaX_mixer_frames_max(GaMixer *m, GaFormat fmt) {
+	f64 step = (f64)fmt.frame_rate / m->format.frame_rate * m->max_pitch;
+	return (usz)(m->num_frames * max(step, 1)) + 3;
+}
+
+// grow sc to at least the given size.  Allocation happens without the lock,
+// so the mixer is only held up for as long as it takes to swap the buffer in
+static ga_result gaX_scratch_reserve(GaMixer *m, GaXMixScratch *sc, usz src_size) {
+	bool grow;
+	with_mutex(m->scratch_mutex) grow = src_size > sc->src_size;
+	if (!grow) return GA_OK;
+
+	void *src = ga_alloc(src_size);
+	if (!src) return GA_ERR_SYS_MEM;
+
+	with_mutex(m->scratch_mutex) {
+		if (src_size > sc->src_size) {
+			void *t = sc->src;
+			sc->src = src;
+			sc->src_size = src_size;
+			src = t;
+		}
+	}
+
+	// whichever buffer lost out
+	ga_free(src);
+	return GA_OK;
+}
+
+// bytes of scratch a handle of the given format needs
+static usz gaX_mixer_scratch_size(GaMixer *m, GaFormat fmt) {
+	return gaX_mixer_frames_max(m, fmt) * ga_format_frame_size(fmt);
+}
+
+// make sure every thread's scratch buffer is at least src_size bytes
+static ga_result gaX_mixer_reserve_scratch(GaMixer *m, usz src_size) {
+	ga_result res = gaX_scratch_reserve(m, &m->scratch, src_size);
+	for (u32 i = 0; i < m->num_workers && ga_isok(res); i++) {
+		res = gaX_scratch_reserve(m, &m->workers[i].scratch, src_size);
+	}
+	return res;
+}
+
+// bytes taken by each of the voice table's arrays, rounded up so every one starts on a cache line
+#define GAX_VOICE_FIELD_SIZE(type, cap) (((cap) * sizeof(type) + 63) & ~(usz)63)
+
+// make sure the voice table has room for n rows.  Grown like the scratch buffers
+static ga_result gaX_mixer_reserve_voices(GaMixer *m, u32 n) {
+	bool grow;
+	with_mutex(m->scratch_mutex) grow = n > m->voices.cap;
+	if (!grow) return GA_OK;
+
+	u32 cap = max(n * 2, 16);
+	usz size = 0;
+#define GAX_VOICE_FIELD(type, name) size += GAX_VOICE_FIELD_SIZE(type, cap);
+	GAX_VOICE_FIELDS(GAX_VOICE_FIELD)
+#undef GAX_VOICE_FIELD
+	char *block = ga_alloc(size + 63);
+	if (!block) return GA_ERR_SYS_MEM;
+
+	GaXVoiceTable t = {.block = block, .cap = cap};
+	char *p = (char*)(((uintptr_t)block + 63) & ~(uintptr_t)63);
+#define GAX_VOICE_FIELD(type, name) t.name = (type*)p; p += GAX_VOICE_FIELD_SIZE(type, cap);
+	GAX_VOICE_FIELDS(GAX_VOICE_FIELD)
+#undef GAX_VOICE_FIELD
+
+	with_mutex(m->scratch_mutex) {
+		if (cap > m->voices.cap) {
+			t.count = m->voices.count;
+#define GAX_VOICE_FIELD(type, name) if (t.count) memcpy(t.name, m->voices.name, t.count * sizeof(type));
+			GAX_VOICE_FIELDS(GAX_VOICE_FIELD)
+#undef GAX_VOICE_FIELD
+			block = m->voices.block;
+			m->voices = t;
+		}
+	}
+	ga_free(block);
+	return GA_OK;
+}
+
+// copy what the game side has set on a handle into its row of the voice table.  Call with scratch_mutex held
+static void gaX_mixer_load_voice(GaMixer *m, u32 i) {
+	GaXVoiceTable *v = &m->voices;
+	GaHandle *h = v->handle[i];
+	v->state[i] = h->state;
+	v->group[i] = h->group;
+	v->start_frame[i] = atomic_load(&h->start_frame);
+	v->stop_frame[i] = atomic_load(&h->stop_frame);
+	v->play_stamp[i] = atomic_load(&h->play_stamp);
+	v->pitch[i] = atomic_load(&h->params.pitch);
+	v->gain[i] = atomic_load(&h->params.gain);
+	v->pan[i] = atomic_load(&h->params.pan);
+	v->priority[i] = atomic_load(&h->params.priority);
+	gaX_mix_matrix(v->matrix[i].m, v->format[i].num_channels, m->format.num_channels, v->gain[i], v->pan[i]);
+}
+
+// give each of n handles a row in the voice table
+static ga_result gaX_mixer_add_voices(GaMixer *m, GaHandle **hs, u32 n) {
+	GaXVoiceTable *v = &m->voices;
+	while (true) {
+		u32 want;
+		with_mutex(m->scratch_mutex) want = v->count + n;
+		ga_result res = gaX_mixer_reserve_voices(m, want);
+		if (!ga_isok(res)) return res;
+
+		ga_mutex_lock(m->scratch_mutex);
+		// someone else may have taken the room in the meantime
+		if (v->count + n > v->cap) {
+			ga_mutex_unlock(m->scratch_mutex);
+			continue;
+		}
+
+		for (u32 k = 0; k < n; k++) {
+			GaHandle *h = hs[k];
+			u32 i = v->count++;
+			v->handle[i] = h;
+			v->src[i] = h->sample_src;
+			v->format[i] = ga_sample_source_format(h->sample_src);
+			v->is_virtual[i] = false;
+			v->resample[i].phase = 0;
+			v->resample[i].step = 0;
+			v->resample[i].primed = false;
+			gaX_mixer_load_voice(m, i);
+			v->last_matrix[i] = v->matrix[i];
+			atomic_store(&h->voice, i);
+		}
+		ga_mutex_unlock(m->scratch_mutex);
+		return GA_OK;
+	}
+}
+
+// make sure there's room for n buses: in the bus list, every thread's table
+// of bus buffers, and the pool those come from
+static ga_result gaX_mixer_reserve_buses(GaMixer *m, u32 n) {
+	bool grow;
+	with_mutex(m->scratch_mutex) grow = n > m->buses_cap;
+	if (!grow) return GA_OK;
+
+	u32 nt = m->num_workers + 1;
+	u32 cap = max(n * 2, 4);
+	// the bus list, then each thread's table
+	void **tables = ga_zalloc((nt + 1) * cap * sizeof(void*));
+	void *pool = ga_alloc(nt * cap * m->num_frames * ga_format_frame_size(m->mix_format));
+	if (!tables || !pool) {
+		ga_free(tables);
+		ga_free(pool);
+		return GA_ERR_SYS_MEM;
+	}
+	with_mutex(m->scratch_mutex) {
+		if (cap > m->buses_cap) {
+			// the threads' tables are empty between mixes, so only the list needs copying
+			for (u32 i = 0; i < m->num_buses; i++) tables[i] = m->buses[i];
+			void **t = (void**)m->buses;
+			void *p = m->bus_pool;
+			m->buses = (GaHandleGroup**)tables;
+			m->scratch.buses = tables + cap;
+			for (u32 i = 0; i < m->num_workers; i++) m->workers[i].scratch.buses = tables + (i + 2) * cap;
+			m->bus_pool = pool;
+			m->buses_cap = cap;
+			tables = t;
+			pool = p;
+		}
+	}
+	ga_free(tables);
+	ga_free(pool);
+	return GA_OK;
+}
+
+static GaHandle *gaX_handle_slot(GaXHandleSlots *hs, u32 slot) {
+	return &hs->pages[slot >> GAX_HANDLE_PAGE_BITS][slot & (GAX_HANDLE_PAGE_SIZE - 1)];
+}
+
+// add a page of free slots.  Call with hs->mutex held
+static bool gaX_handle_add_page(GaMixer *m) {
+	GaXHandleSlots *hs = &m->handles;
+	u32 n = atomic_load(&hs->num_pages);
+	if (n == GAX_HANDLE_MAX_PAGES) return false;
+	GaHandle *page = ga_alloc(GAX_HANDLE_PAGE_SIZE * sizeof(GaHandle));
+	if (!page) return false;
+	for (u32 i = 0; i < GAX_HANDLE_PAGE_SIZE; i++) {
+		page[i].mixer = m;
+		page[i].slot = n * GAX_HANDLE_PAGE_SIZE + i;
+		page[i].generation = 1;
+		// if this fails, ga_handle_create tries again
+		if (!ga_isok(ga_mutex_create(&page[i].mutex))) page[i].mutex.mutex = NULL;
+		page[i].next_free = i + 1 < GAX_HANDLE_PAGE_SIZE ? page[i].slot + 1 : hs->free;
+	}
+	hs->pages[n] = page;
+	atomic_store(&hs->num_pages, n + 1);
+	hs->free = n * GAX_HANDLE_PAGE_SIZE;
+	hs->stats.free += GAX_HANDLE_PAGE_SIZE;
+	return true;
+}
+
+// return n handles' slots to the free list; their ids are stale from here on
+static void gaX_handle_free(GaHandle **out, usz n) {
+	if (!n) return;
+	GaXHandleSlots *hs = &out[0]->mixer->handles;
+	with_mutex(hs->mutex) {
+		for (usz i = 0; i < n; i++) {
+			GaHandle *h = out[i];
+			u32 gen = atomic_load(&h->generation) + 1;
+			atomic_store(&h->generation, gen ? gen : 1);
+			h->next_free = hs->free;
+			hs->free = h->slot;
+			hs->stats.free++;
+			hs->stats.in_use--;
+		}
+	}
+}
+
+// take free slots for n new handles, adding pages if there aren't enough
+static ga_result gaX_handle_alloc(GaMixer *m, GaHandle **out, usz n) {
+	GaXHandleSlots *hs = &m->handles;
+	usz got = 0;
+	with_mutex(hs->mutex) {
+		for (; got < n; got++) {
+			if (hs->free == GAX_NO_SLOT) {
+				hs->stats.misses++;
+				if (!gaX_handle_add_page(m)) break;
+			}
+			GaHandle *h = out[got] = gaX_handle_slot(hs, hs->free);
+			hs->free = h->next_free;
+			hs->stats.free--;
+			hs->stats.in_use++;
+		}
+		hs->stats.peak = max(hs->stats.peak, hs->stats.in_use);
+	}
+	if (got == n) return GA_OK;
+
+	ga_err("out of handle slots");
+	gaX_handle_free(out, got);
+	return GA_ERR_SYS_MEM;
+}
+
+GaPoolStats ga_mixer_handle_pool_stats(GaMixer *m) {
+	GaPoolStats ret;
+	with_mutex(m->handles.mutex) ret = m->handles.stats;
+	return ret;
+}
+
+ga_result ga_mixer_handle_pool_reserve(GaMixer *m, usz num_free) {
+	ga_result res = GA_OK;
+	with_mutex(m->handles.mutex) {
+		while (ga_isok(res) && m->handles.stats.free < num_free) {
+			if (!gaX_handle_add_page(m)) res = atomic_load(&m->handles.num_pages) == GAX_HANDLE_MAX_PAGES ? GA_ERR_MIS_RANGE : GA_ERR_SYS_MEM;
+		}
+	}
+	return res;
 }
 
 /* Handle Functions */
-GaHandle *ga_handle_create(GaMixer *mixer, GaSampleSource *src, GaHandleGroup *hg) {
-	GaHandle *h = ga_alloc(sizeof(GaHandle));
-	if (!h) return NULL;
-	ga_sample_source_acquire(src);
-	h->sample_src = src;
-
-	h->state = GaHandleState_Initial;
-	h->mixer = mixer;
-	h->callback = NULL;
-	h->context = NULL;
-	memset(h->jukebox_stamps, 0, sizeof(h->jukebox_stamps));
-	init_jukeboxstate(&h->jukebox);
-
-	if (!ga_isok(ga_mutex_create(&h->mutex))) {
-		ga_sample_source_release(src);
-		ga_free(h);
-		return NULL;
+ga_result ga_handle_create_batch(GaMixer *mixer, GaSampleSource *const *srcs, usz n, GaHandleGroup *hg, GaHandle **out) {
+	if (n > UINT32_MAX / 4) return GA_ERR_MIS_RANGE;
+	usz src_size = 0;
+	for (usz i = 0; i < n; i++) {
+		GaFormat fmt = ga_sample_source_format(srcs[i]);
+		if (!fmt.num_channels || fmt.num_channels > GAX_MAX_CHANNELS) {
+			ga_err("can't mix a source with %u channels", fmt.num_channels);
+			return GA_ERR_MIS_PARAM;
+		}
+		src_size = max(src_size, gaX_mixer_scratch_size(mixer, fmt));
+	}
+	if (!n) return GA_OK;
+
+	ga_result res = gaX_handle_alloc(mixer, out, n);
+	if (!ga_isok(res)) return res;
+	for (usz i = 0; i < n; i++) {
+		// a slot keeps its mutex from one handle to the next
+		if (!out[i]->mutex.mutex && !ga_isok(res = ga_mutex_create(&out[i]->mutex))) {
+			gaX_handle_free(out, n);
+			return res;
+		}
 	}
 
-	if (!hg) hg = &mixer->handle_group;
-	h->group = hg;
-	ga_list_link(&h->group->handles, &h->group_link, h);
+	for (usz i = 0; i < n; i++) {
+		GaHandle *h = out[i];
+		ga_sample_source_acquire(srcs[i]);
+		h->sample_src = srcs[i];
+
+		h->state = GaHandleState_Initial;
+		h->callback = NULL;
+		h->context = NULL;
+		h->dirty = false;
+		h->next_dirty = NULL;
+		h->done = 0;
+		h->finish_event = (GaXHandleEvent){.handle = h};
+		h->cleanup_event = (GaXHandleEvent){.handle = h};
+		h->finish_dispatched = false;
+		h->voice = GAX_NO_VOICE;
+		h->params.priority = 0;
+		h->play_stamp = 0;
+		h->virtual_frames = 0;
+		h->start_frame = 0;
+		h->stop_frame = UINT64_MAX;
+	}
 
-	GaFormat fmt = ga_handle_format(h);
-	//todo channelnum should be min()
-	if (fmt.frame_rate != mixer->format.frame_rate) assert(h->resample_state = ga_trans_resample_setup(mixer->format.frame_rate, fmt));
-	else h->resample_state = NULL;
+	if (!hg) hg = &mixer->handle_group;
+	with_mutex(hg->mutex) {
+		for (usz i = 0; i < n; i++) {
+			GaHandle *h = out[i];
+			h->group = hg;
+			atomic_store(&h->params.pitch, hg->params.pitch);
+			atomic_store(&h->params.gain, hg->params.gain);
+			atomic_store(&h->params.pan, hg->params.pan);
+			ga_list_link(&hg->handles, &h->group_link, h);
+		}
+	}
 
-	with_mutex(mixer->mix_mutex) {
-		ga_list_link(&mixer->mix_list, &h->mix_link, h);
+	if (!ga_isok(res = gaX_mixer_reserve_scratch(mixer, src_size))
+	 || !ga_isok(res = gaX_mixer_add_voices(mixer, out, n))) {
+		with_mutex(hg->mutex) {
+			for (usz i = 0; i < n; i++) ga_list_unlink(&out[i]->group_link);
+		}
+		for (usz i = 0; i < n; i++) ga_sample_source_release(srcs[i]);
+		gaX_handle_free(out, n);
+		return res;
 	}
 
 	with_mutex(mixer->dispatch_mutex) {
-		ga_list_link(&mixer->dispatch_list, &h->dispatch_link, h);
+		for (usz i = 0; i < n; i++) ga_list_link(&mixer->dispatch_list, &out[i]->dispatch_link, out[i]);
 	}
 
-	return h;
+	return GA_OK;
+}
+
+GaHandle *ga_handle_create(GaMixer *mixer, GaSampleSource *src, GaHandleGroup *hg) {
+	GaHandle *ret;
+	return ga_isok(ga_handle_create_batch(mixer, &src, 1, hg, &ret)) ? ret : NULL;
 }
 
 void ga_handle_destroy(GaHandle *handle) {
@@ -547,29 +995,104 @@ void ga_handle_destroy(GaHandle *handle) {
 	ga_mutex_lock(handle->mutex);
 	handle->state = GaHandleState_Destroyed;
 	ga_mutex_unlock(handle->mutex);
+	gaX_handle_post(handle);
+
+	u8 done = atomic_fetch_or(&handle->done, GaXHandleDone_Destroyed);
+	if (done == GaXHandleDone_Retired) gaX_mixer_push_event(handle->mixer, &handle->cleanup_event);
 }
 
 static ga_result gaX_handle_cleanup(GaHandle *handle) {
 	/* May only be called from the dispatch thread */
-	if (handle->resample_state) ga_trans_resample_teardown(handle->resample_state);
 	ga_sample_source_release(handle->sample_src);
-	ga_list_unlink(&handle->group_link);
-	ga_mutex_destroy(handle->mutex);
-	ga_free(handle);
+	if (handle->group_link.next) with_mutex(handle->group->mutex) ga_list_unlink(&handle->group_link);
+	gaX_handle_free(&handle, 1);
 	return GA_OK;
 }
 
-ga_result ga_handle_play(GaHandle *handle) {
+// should a be stolen before b?
+static bool gaX_handle_steal_before(GaVoiceSteal steal, GaHandle *a, GaHandle *b) {
+	switch (steal) {
+		case GaVoiceSteal_Quietest: {
+			f32 ga = atomic_load(&a->params.gain), gb = atomic_load(&b->params.gain);
+			if (ga != gb) return ga < gb;
+			break;
+		}
+		case GaVoiceSteal_LowestPriority: {
+			s32 pa = atomic_load(&a->params.priority), pb = atomic_load(&b->params.priority);
+			if (pa != pb) return pa < pb;
+			break;
+		}
+		default: break;
+	}
+	return atomic_load(&a->play_stamp) < atomic_load(&b->play_stamp);
+}
+
+// finish handles in g until h can start playing without exceeding its limit.  Call with g's mutex held
+static ga_result gaX_handle_group_make_room(GaHandleGroup *g, GaHandle *h) {
+	if (!g->max_playing || h->state == GaHandleState_Playing) return GA_OK;
+
+	while (true) {
+		u32 playing = 0;
+		GaHandle *victim = NULL;
+		ga_list_iterate(GaHandle, o, &g->handles) {
+			if (o == h || o->state != GaHandleState_Playing) continue;
+			playing++;
+			if (!victim || gaX_handle_steal_before(g->steal, o, victim)) victim = o;
+		}
+		if (playing < g->max_playing) return GA_OK;
+		if (g->steal == GaVoiceSteal_None) return GA_ERR_MIS_UNSUP;
+		if (g->steal == GaVoiceSteal_LowestPriority && atomic_load(&victim->params.priority) > atomic_load(&h->params.priority)) return GA_ERR_MIS_UNSUP;
+
+		with_mutex(victim->mutex) {
+			if (victim->state < GaHandleState_Finished) victim->state = GaHandleState_Finished;
+		}
+		gaX_handle_post(victim);
+	}
+}
+
+// set the handle playing, without posting it.  Call with handle->group's mutex held
+static ga_result gaX_handle_start(GaHandle *handle) {
+	ga_result res = gaX_handle_group_make_room(handle->group, handle);
+	if (!ga_isok(res)) return res;
+
 	ga_mutex_lock(handle->mutex);
 	if (handle->state >= GaHandleState_Finished) {
 		ga_mutex_unlock(handle->mutex);
 		return GA_ERR_MIS_UNSUP;
 	}
+	if (handle->state != GaHandleState_Playing) atomic_store(&handle->play_stamp, atomic_fetch_add(&handle->mixer->plays, 1));
 	handle->state = GaHandleState_Playing;
 	ga_mutex_unlock(handle->mutex);
 	return GA_OK;
 }
 
+// call with handle->group's mutex held
+static ga_result gaX_handle_play(GaHandle *handle) {
+	ga_result res = gaX_handle_start(handle);
+	if (ga_isok(res)) gaX_handle_post(handle);
+	return res;
+}
+
+// set when a handle is to start, dropping any stop that would come first
+static void gaX_handle_schedule(GaHandle *handle, u64 frame) {
+	u64 now = atomic_load(&handle->mixer->clock);
+	u64 stop = atomic_load(&handle->stop_frame);
+	if (stop <= max(frame, now)) atomic_compare_exchange_strong(&handle->stop_frame, &stop, UINT64_MAX);
+	atomic_store(&handle->start_frame, frame);
+}
+
+ga_result ga_handle_play_at(GaHandle *handle, u64 frame) {
+	gaX_handle_schedule(handle, frame);
+
+	ga_result res;
+	with_mutex(handle->group->mutex) res = gaX_handle_play(handle);
+	return res;
+}
+
+ga_result ga_handle_play(GaHandle *handle) {
+	return ga_handle_play_at(handle, 0);
+}
+
 ga_result ga_handle_stop(GaHandle *handle) {
 	ga_mutex_lock(handle->mutex);
 	if (handle->state >= GaHandleState_Finished) {
@@ -577,10 +1100,22 @@ ga_result ga_handle_stop(GaHandle *handle) {
 		return GA_ERR_MIS_UNSUP;
 	}
 	handle->state = GaHandleState_Stopped;
+	atomic_store(&handle->stop_frame, UINT64_MAX);
 	ga_mutex_unlock(handle->mutex);
+	gaX_handle_post(handle);
 	return GA_OK;
 }
 
+ga_result ga_handle_stop_at(GaHandle *handle, u64 frame) {
+	ga_result res = GA_OK;
+	with_mutex(handle->mutex) {
+		if (handle->state >= GaHandleState_Finished) res = GA_ERR_MIS_UNSUP;
+		else atomic_store(&handle->stop_frame, frame);
+	}
+	if (ga_isok(res)) gaX_handle_post(handle);
+	return res;
+}
+
 bool ga_handle_playing(GaHandle *handle) {
 	return handle->state == GaHandleState_Playing;
 }
@@ -598,119 +1133,199 @@ void ga_handle_set_callback(GaHandle *handle, GaCbHandleFinish callback, void *c
 	/* Does not need mutex because it can only be called from the dispatch thread */
 	handle->callback = callback;
 	handle->context = context;
+	// already finished?  Then the next dispatch calls it
+	if (callback && handle->finish_dispatched) {
+		handle->finish_dispatched = false;
+		gaX_mixer_push_event(handle->mixer, &handle->finish_event);
+	}
 }
 
-ga_result ga_handle_set_paramf(GaHandle *handle, GaHandleParam param, f32 value) {
-	ga_mutex_lock(handle->mutex);
+static atomic_f32 *handle_get_paramf(GaHandle *handle, GaHandleParam param) {
 	switch (param) {
-		case GaHandleParam_Pitch: handle->jukebox.pitch = value; break;
-		case GaHandleParam_Gain:  handle->jukebox.gain = value;  break;
-		case GaHandleParam_Pan:
-			if (param == GaHandleParam_Pan && (value < -1 || value > 1)) {
-				ga_mutex_unlock(handle->mutex);
-				return GA_ERR_MIS_RANGE;
-			}
-
-			handle->jukebox.pan = value;
-			break;
-		default:
-			ga_mutex_unlock(handle->mutex);
-			return GA_ERR_MIS_PARAM;
+		case GaHandleParam_Pitch: return &handle->params.pitch;
+		case GaHandleParam_Gain:  return &handle->params.gain;
+		case GaHandleParam_Pan:   return &handle->params.pan;
+		default: return NULL;
 	}
-	handle->jukebox_stamps[param] = autoincrement();
-	ga_mutex_unlock(handle->mutex);
-	return GA_OK;
 }
 
-static f32 *handle_get_paramf(GaHandle *handle, GaXHandleParam param) {
-	f32 *hp, *gp;
-
+// whether value is in range for param; the mixer relies on pitch being sane
+static bool gaX_paramf_valid(GaHandleParam param, f32 value) {
 	switch (param) {
-		case GaXHandleParam_Pitch:     hp = &handle->jukebox.pitch;        gp = &handle->group->jukebox.pitch;      break;
-		case GaXHandleParam_Gain:      hp = &handle->jukebox.gain;         gp = &handle->group->jukebox.gain;       break;
-		case GaXHandleParam_LastGain:  hp = &handle->jukebox.last_gain;    gp = &handle->group->jukebox.last_gain;  break;
-		case GaXHandleParam_Pan:       hp = &handle->jukebox.pan;          gp = &handle->group->jukebox.pan;        break;
-		case GaXHandleParam_LastPan:   hp = &handle->jukebox.last_pan;     gp = &handle->group->jukebox.last_pan;   break;
-		default: assert(0);
+		case GaHandleParam_Pan:   return value >= -1 && value <= 1;
+		case GaHandleParam_Pitch: return value >= 0 && isfinite(value);
+		default: return true;
 	}
+}
 
-	return handle->jukebox_stamps[param] > handle->group->jukebox_stamps[param] ? hp : gp;
+ga_result ga_handle_set_paramf(GaHandle *handle, GaHandleParam param, f32 value) {
+	atomic_f32 *f = handle_get_paramf(handle, param);
+	if (!f) return GA_ERR_MIS_PARAM;
+	if (!gaX_paramf_valid(param, value)) return GA_ERR_MIS_RANGE;
+
+	atomic_store(f, value);
+	gaX_handle_post(handle);
+	return GA_OK;
 }
 
 ga_result ga_handle_get_paramf(GaHandle *handle, GaHandleParam param, f32 *value) {
-	switch (param) {
-		case GaHandleParam_Pitch:
-		case GaHandleParam_Pan:
-		case GaHandleParam_Gain:
-			with_mutex(handle->mutex) *value = *handle_get_paramf(handle, (GaXHandleParam)param);
-			return GA_OK;
-		default: return GA_ERR_MIS_PARAM;
-	}
+	atomic_f32 *f = handle_get_paramf(handle, param);
+	if (!f) return GA_ERR_MIS_PARAM;
+	*value = atomic_load(f);
+	return GA_OK;
 }
 
 static f32 *handle_group_get_paramf(GaHandleGroup *g, GaHandleParam param) {
 	switch (param) {
-		case GaHandleParam_Pitch: return &g->jukebox.pitch;
-		case GaHandleParam_Gain:  return &g->jukebox.gain;
-		case GaHandleParam_Pan:   return &g->jukebox.pan;
-		default: assert(0);
+		case GaHandleParam_Pitch: return &g->params.pitch;
+		case GaHandleParam_Gain:  return &g->params.gain;
+		case GaHandleParam_Pan:   return &g->params.pan;
+		default: return NULL;
 	}
 }
 
 ga_result ga_handle_group_set_paramf(GaHandleGroup *g, GaHandleParam param, f32 value) {
+	f32 *f = handle_group_get_paramf(g, param);
+	if (!f) return GA_ERR_MIS_PARAM;
+	if (!gaX_paramf_valid(param, value)) return GA_ERR_MIS_RANGE;
+
+	// whichever of this and ga_handle_set_paramf happened last wins
+	with_mutex(g->mutex) {
+		*f = value;
+		ga_list_iterate(GaHandle, h, &g->handles) {
+			atomic_store(handle_get_paramf(h, param), value);
+			gaX_handle_post(h);
+		}
+	}
+	return GA_OK;
+}
+ga_result ga_handle_group_get_paramf(GaHandleGroup *g, GaHandleParam param, f32 *value) {
+	f32 *f = handle_group_get_paramf(g, param);
+	if (!f) return GA_ERR_MIS_PARAM;
+	with_mutex(g->mutex) *value = *f;
+	return GA_OK;
+}
+
+ga_result ga_handle_set_parami(GaHandle *handle, GaHandleParam param, s32 value) {
 	switch (param) {
-		case GaHandleParam_Pitch:
-		case GaHandleParam_Gain:
-		case GaHandleParam_Pan:;
-			f32 *f = handle_group_get_paramf(g, param);
-			with_mutex(g->mutex) *f = value;
+		case GaHandleParam_Priority:
+			atomic_store(&handle->params.priority, value);
+			gaX_handle_post(handle);
 			return GA_OK;
 		default: return GA_ERR_MIS_PARAM;
 	}
 }
-ga_result ga_handle_group_get_paramf(GaHandleGroup *g, GaHandleParam param, f32 *value) {
+
+ga_result ga_handle_get_parami(GaHandle *handle, GaHandleParam param, s32 *value) {
 	switch (param) {
-		case GaHandleParam_Pitch:
-		case GaHandleParam_Gain:
-		case GaHandleParam_Pan:;
-			f32 *f = handle_group_get_paramf(g, param);
-			with_mutex(g->mutex) *value = *f;
-			return GA_OK;
+		case GaHandleParam_Priority: *value = atomic_load(&handle->params.priority); return GA_OK;
 		default: return GA_ERR_MIS_PARAM;
 	}
 }
 
-ga_result ga_handle_set_parami(GaHandle *handle, GaHandleParam param, s32 value) {
-	/*
-	   switch(param)
-	   {
-	   case GaHandleParam_?:
-	   ga_mutex_lock(handle->mutex);
-	   ga_mutex_unlock(handle->mutex);
-	   return GA_OK;
-	   }
-	   */
-	return GA_ERR_MIS_PARAM;
+ga_result ga_handle_group_set_limit(GaHandleGroup *g, u32 max_playing, GaVoiceSteal steal) {
+	if (steal < GaVoiceSteal_None || steal > GaVoiceSteal_LowestPriority) return GA_ERR_MIS_PARAM;
+	with_mutex(g->mutex) {
+		g->max_playing = max_playing;
+		g->steal = steal;
+	}
+	return GA_OK;
 }
 
-ga_result ga_handle_get_parami(GaHandle *handle, GaHandleParam param, s32 *value) {
-	/*
-	   switch(param)
-	   {
-	   case GaHandleParam_?: *value = ?; return GA_OK;
-	   }
-	   */
-	return GA_ERR_MIS_PARAM;
+static u32 gaX_bus_depth(GaHandleGroup *g) {
+	u32 ret = 0;
+	while ((g = g->parent)) ret++;
+	return ret;
+}
+
+// order the buses deepest first, and renumber them.  Call with scratch_mutex held
+static void gaX_mixer_sort_buses(GaMixer *m) {
+	for (u32 i = 1; i < m->num_buses; i++) {
+		GaHandleGroup *g = m->buses[i];
+		u32 depth = gaX_bus_depth(g);
+		u32 j = i;
+		for (; j > 0 && gaX_bus_depth(m->buses[j - 1]) < depth; j--) m->buses[j] = m->buses[j - 1];
+		m->buses[j] = g;
+	}
+	for (u32 i = 0; i < m->num_buses; i++) m->buses[i]->bus_index = i;
+}
+
+ga_result ga_handle_group_route(GaHandleGroup *g, GaHandleGroup *parent) {
+	GaMixer *m = g->mixer;
+	if (parent == &m->handle_group) parent = NULL;
+	if (g == &m->handle_group || (parent && parent->mixer != m)) return GA_ERR_MIS_PARAM;
+
+	while (true) {
+		u32 n;
+		with_mutex(m->scratch_mutex) n = m->num_buses + !g->is_bus;
+		ga_result res = gaX_mixer_reserve_buses(m, n);
+		if (!ga_isok(res)) return res;
+
+		ga_mutex_lock(m->scratch_mutex);
+		// someone else may have added a bus in the meantime
+		if (m->num_buses + !g->is_bus > m->buses_cap) {
+			ga_mutex_unlock(m->scratch_mutex);
+			continue;
+		}
+
+		if (parent && !parent->is_bus) res = GA_ERR_MIS_PARAM;
+		for (GaHandleGroup *p = parent; p; p = p->parent) {
+			if (p == g) res = GA_ERR_MIS_PARAM;
+		}
+		if (ga_isok(res)) {
+			if (!g->is_bus) {
+				g->is_bus = true;
+				g->last_bus_gain = atomic_load(&g->bus_gain);
+				m->buses[m->num_buses++] = g;
+			}
+			g->parent = parent;
+			gaX_mixer_sort_buses(m);
+		}
+		ga_mutex_unlock(m->scratch_mutex);
+		return res;
+	}
+}
+
+void ga_handle_group_unroute(GaHandleGroup *g) {
+	GaMixer *m = g->mixer;
+	with_mutex(m->scratch_mutex) if (g->is_bus) {
+		for (u32 i = 0; i < m->num_buses; i++) {
+			if (m->buses[i]->parent == g) m->buses[i]->parent = g->parent;
+		}
+		for (u32 i = g->bus_index + 1; i < m->num_buses; i++) m->buses[i - 1] = m->buses[i];
+		m->num_buses--;
+		g->is_bus = false;
+		g->parent = NULL;
+		gaX_mixer_sort_buses(m);
+	}
+}
+
+ga_result ga_handle_group_set_bus_gain(GaHandleGroup *g, f32 gain) {
+	if (!(gain >= 0)) return GA_ERR_MIS_RANGE;
+	atomic_store(&g->bus_gain, gain);
+	return GA_OK;
+}
+
+void ga_handle_group_set_bus_effect(GaHandleGroup *g, GaCbBusEffect effect, void *context) {
+	with_mutex(g->mixer->scratch_mutex) {
+		g->effect = effect;
+		g->effect_context = context;
+	}
 }
 
 ga_result ga_handle_seek(GaHandle *handle, usz frame_offset) {
+	// forget any frames skipped while virtual
+	atomic_store(&handle->virtual_frames, 0);
 	return ga_sample_source_seek(handle->sample_src, frame_offset);
 }
 
 ga_result ga_handle_tell(GaHandle *handle, GaTellParam param, usz *out) {
 	if (!out) return GA_ERR_MIS_PARAM;
-	if (param == GaTellParam_Current) return ga_sample_source_tell(handle->sample_src, out, NULL);
-	else if (param == GaTellParam_Total) return ga_sample_source_tell(handle->sample_src, NULL, out);
+	if (param == GaTellParam_Current) {
+		ga_result res = ga_sample_source_tell(handle->sample_src, out, NULL);
+		if (ga_isok(res)) *out += atomic_load(&handle->virtual_frames);
+		return res;
+	} else if (param == GaTellParam_Total) return ga_sample_source_tell(handle->sample_src, NULL, out);
 	else return GA_ERR_MIS_PARAM;
 }
 
@@ -722,6 +1337,17 @@ GaFormat ga_handle_format(GaHandle *handle) {
 	return ga_sample_source_format(handle->sample_src);
 }
 
+GaHandleId ga_handle_id(GaHandle *handle) {
+	return (u64)atomic_load(&handle->generation) << 32 | handle->slot;
+}
+
+GaHandle *ga_handle_lookup(GaMixer *m, GaHandleId id) {
+	u32 slot = (u32)id;
+	if (slot >> GAX_HANDLE_PAGE_BITS >= atomic_load(&m->handles.num_pages)) return NULL;
+	GaHandle *h = gaX_handle_slot(&m->handles, slot);
+	return atomic_load(&h->generation) == id >> 32 ? h : NULL;
+}
+
 GaHandleGroup *ga_mixer_handle_group(GaMixer *m) {
 	return &m->handle_group;
 }
@@ -730,8 +1356,8 @@ static ga_result gaX_handle_group_init(GaHandleGroup *g, GaMixer *m) {
 	memset(g, 0, sizeof(*g));
 	ga_list_head(&g->handles);
 	g->mixer = m;
-	memset(g->jukebox_stamps, 0, sizeof(g->jukebox_stamps));
-	init_jukeboxstate(&g->jukebox);
+	g->params = (GaXHandleParams){.pitch = 1, .gain = 1, .pan = 0};
+	g->bus_gain = 1;
 	return ga_mutex_create(&g->mutex);
 
 }
@@ -752,11 +1378,13 @@ void ga_handle_group_add(GaHandleGroup *group, GaHandle *handle) {
 	if (handle->group == group) return;
 
 	with_mutex(group->mutex) {
-		with_mutex(handle->group->mutex) {
+		GaHandleGroup *old = handle->group;
+		with_mutex(old->mutex) {
 			handle->group = group;
 			ga_list_unlink(&handle->group_link);
 		}
 		ga_list_link(&group->handles, &handle->group_link, handle);
+		gaX_handle_set_params(handle, &group->params);
 	}
 }
 
@@ -774,6 +1402,10 @@ void ga_handle_group_transfer(GaHandleGroup *group, GaHandleGroup *target) {
 	}
 
 	with_mutex(target->mutex) {
+		ga_list_iterate(GaHandle, h, &group->handles) {
+			h->group = target;
+			gaX_handle_set_params(h, &target->params);
+		}
 		ga_list_merge(&target->handles, &group->handles);
 	}
 
@@ -784,13 +1416,22 @@ void ga_handle_group_disown(GaHandleGroup *group) {
 	ga_handle_group_transfer(group, NULL);
 }
 
+// Destroy the group's handles.  Until the mixer drains them, which a hold
+// (see gaX_mixer_hold) can put off past the group being freed, their rows in
+// the voice table would still point at it; so they, and any other row left
+// pointing at the group, are handed over to the mixer's group first
 static void gaX_handle_group_destroy(GaHandleGroup *group) {
-	with_mutex(group->mutex) {
+	GaMixer *m = group->mixer;
+	GaXVoiceTable *v = &m->voices;
+	with_mutex(group->mutex) with_mutex(m->scratch_mutex) {
 		ga_list_iterate(GaHandle, h, &group->handles) {
+			ga_list_unlink(&h->group_link);
+			h->group = &m->handle_group;
 			ga_handle_destroy(h);
 		}
-
-		ga_list_head(&group->handles);
+		for (u32 i = 0; i < v->count; i++) {
+			if (v->group[i] == group) v->group[i] = &m->handle_group;
+		}
 	}
 
 	ga_mutex_destroy(group->mutex);
@@ -798,13 +1439,34 @@ static void gaX_handle_group_destroy(GaHandleGroup *group) {
 
 void ga_handle_group_destroy(GaHandleGroup *group) {
 	gaX_handle_group_destroy(group);
+	// no voice row points at the group now; this takes it off the buses, and
+	// waits out a mix in progress, which may still be using it as one
+	ga_handle_group_unroute(group);
 	ga_free(group);
 }
 
-void ga_handle_group_play(GaHandleGroup *group) {
-	with_mutex(group->mutex) ga_list_iterate(GaHandle, h, &group->handles) {
-		ga_handle_play(h);
+void ga_handle_group_play_at(GaHandleGroup *group, u64 frame) {
+	// The hold keeps any member queued before now (or a victim of make_room)
+	// from being picked up a mix ahead of the rest; the rest go onto the
+	// dirty list together when it's let go
+	GaMixer *m = group->mixer;
+	GaHandle *first = NULL, *last = NULL;
+	gaX_mixer_hold(m);
+	with_mutex(group->mutex) {
+		ga_list_iterate(GaHandle, h, &group->handles) {
+			gaX_handle_schedule(h, frame);
+			if (ga_isok(gaX_handle_start(h)) && !atomic_exchange(&h->dirty, true)) {
+				h->next_dirty = first;
+				first = h;
+				if (!last) last = h;
+			}
+		}
 	}
+	gaX_mixer_release(m, first, last);
+}
+
+void ga_handle_group_play(GaHandleGroup *group) {
+	ga_handle_group_play_at(group, 0);
 }
 void ga_handle_group_stop(GaHandleGroup *group) {
 	with_mutex(group->mutex) ga_list_iterate(GaHandle, h, &group->handles) {
@@ -835,32 +1497,133 @@ static void gaX_mixer_reset(GaMixer *m, const GaFormat *format, u32 num_frames)
 }
 #endif
 
+static ga_result gaX_mix_worker(void *context);
+
+static void gaX_mixer_stop_workers(GaMixer *m) {
+	if (!m->workers) return;
+	for (u32 i = 0; i < m->num_workers; i++) {
+		GaXMixWorker *w = &m->workers[i];
+		if (w->thread) {
+			w->quit = true;
+			ga_semaphore_post(w->start);
+			ga_thread_join(w->thread);
+			ga_thread_destroy(w->thread);
+		}
+		ga_semaphore_destroy(w->start);
+		ga_free(w->mix_buffer);
+		ga_free(w->scratch.src);
+	}
+	ga_semaphore_destroy(m->workers_done);
+	ga_free(m->workers);
+	m->workers = NULL;
+	m->num_workers = 0;
+}
+
+static ga_result gaX_mixer_start_workers(GaMixer *m, u32 num_workers) {
+	if (!(m->workers = ga_zalloc(num_workers * sizeof(GaXMixWorker)))) return GA_ERR_SYS_MEM;
+	m->num_workers = num_workers;
+	ga_result res = ga_semaphore_create(&m->workers_done, 0);
+	if (!ga_isok(res)) return res;
+
+	for (u32 i = 0; i < num_workers; i++) {
+		GaXMixWorker *w = &m->workers[i];
+		w->mixer = m;
+		if (!(w->mix_buffer = ga_alloc(m->num_frames * ga_format_frame_size(m->mix_format)))) return GA_ERR_SYS_MEM;
+		if (!ga_isok(res = ga_semaphore_create(&w->start, 0))) return res;
+		if (!(w->thread = ga_thread_create(gaX_mix_worker, w, GaThreadPriority_Highest, 64 * 1024))) return GA_ERR_SYS_LIB;
+	}
+
+	ga_trace("mixing on %u threads", num_workers + 1);
+	return GA_OK;
+}
+
 /* Mixer Functions */
-GaMixer *ga_mixer_create(GaFormat format, u32 num_frames) {
-	GaMixer *ret = ga_alloc(sizeof(GaMixer));
+// back to unity gain, as after a long enough silence
+static void gaX_limiter_reset(GaXLimiter *l) {
+	for (u32 i = 0; i <= GAX_LIMITER_LOOKAHEAD; i++) l->held[i] = 1;
+	l->min_count = 0;
+}
+
+static ga_result gaX_mixer_limiter_init(GaMixer *m, f32 ceiling, f32 release) {
+	const u32 L = GAX_LIMITER_LOOKAHEAD;
+	usz delay_size = (L + m->num_frames) * ga_format_frame_size(m->mix_format);
+	GaXLimiter *l = ga_zalloc(sizeof(GaXLimiter) + delay_size + (2 * m->num_frames + 3 * (L + 1)) * sizeof(f32));
+	if (!l) return GA_ERR_SYS_MEM;
+	l->delay = l + 1;
+	l->peaks = (f32*)((char*)l->delay + delay_size);
+	l->gains = l->peaks + m->num_frames;
+	l->min_gain = l->gains + m->num_frames;
+	l->min_frame = (u32*)(l->min_gain + L + 1);
+	l->held = (f32*)(l->min_frame + L + 1);
+	gaX_limiter_reset(l);
+	l->ceiling = ceiling > 0 ? ceiling : 1;
+	l->release = 1 - expf(-1 / ((release > 0 ? release : 0.1f) * m->format.frame_rate));
+	m->limiter = l;
+	return GA_OK;
+}
+
+GaMixer *ga_mixer_create_ext(const GaMixerCreationMinutiae *m) {
+	GaSampleFormat mix_fmt = m->mix_fmt ? m->mix_fmt : GaSampleFormat_S32;
+	if (mix_fmt != GaSampleFormat_S32 && mix_fmt != GaSampleFormat_F32) {
+		ga_err("unsupported mix bus format %d", mix_fmt);
+		return NULL;
+	}
+
+	if (!m->format.num_channels || m->format.num_channels > GAX_MAX_CHANNELS) {
+		ga_err("can't mix to %u channels", m->format.num_channels);
+		return NULL;
+	}
+
+	GaMixer *ret = ga_zalloc(sizeof(GaMixer));
 	if (!ret) return NULL;
 	if (!ga_isok(gaX_handle_group_init(&ret->handle_group, ret))) goto fail;
 	if (!ga_isok(ga_mutex_create(&ret->dispatch_mutex))) goto fail;
-	if (!ga_isok(ga_mutex_create(&ret->mix_mutex))) goto fail;
+	if (!ga_isok(ga_mutex_create(&ret->scratch_mutex))) goto fail;
+	if (!ga_isok(ga_mutex_create(&ret->handles.mutex))) goto fail;
+	if (!ga_isok(ga_semaphore_create(&ret->wake, 0))) goto fail;
+	ret->handles.free = GAX_NO_SLOT;
 	ga_list_head(&ret->dispatch_list);
-	ga_list_head(&ret->mix_list);
-	ret->num_frames = num_frames;
-	ret->format = format;
-	ret->mix_format.sample_fmt = GaSampleFormat_S32; //not exactly.  s32 dynamic range, but normalized to s16 magnitude
-	ret->mix_format.num_channels = format.num_channels;
-	ret->mix_format.frame_rate = format.frame_rate;
-	ret->mix_buffer = ga_alloc(num_frames * ga_format_frame_size(ret->mix_format));
+	ret->num_frames = m->num_frames;
+	ret->max_pitch = m->max_pitch > 0 && isfinite(m->max_pitch) ? m->max_pitch : 4;
+	ret->max_voices = m->max_voices;
+	ret->virtual_gain = m->virtual_gain;
+	ret->format = m->format;
+	ret->mix_format.sample_fmt = mix_fmt; //S32 is not exactly.  s32 dynamic range, but normalized to s16 magnitude
+	ret->mix_format.num_channels = m->format.num_channels;
+	ret->mix_format.frame_rate = m->format.frame_rate;
+	ret->mix_buffer = ga_alloc(m->num_frames * ga_format_frame_size(ret->mix_format));
 	ret->suspended = false;
+	ret->kernels = gaX_mix_kernels_select();
+	ga_trace("using %s mix kernels, %s mix bus", ret->kernels->name, mix_fmt == GaSampleFormat_F32 ? "f32" : "s32");
+	if (m->limiter && !ga_isok(gaX_mixer_limiter_init(ret, m->limiter_ceiling, m->limiter_release))) goto fail;
+	// the s32 bus has nothing below an s16 lsb to dither
+	if (m->dither && (m->format.sample_fmt == GaSampleFormat_U8
+	               || (m->format.sample_fmt == GaSampleFormat_S16 && mix_fmt == GaSampleFormat_F32))) {
+		ret->noise = ga_zalloc((m->num_frames + 1) * m->format.num_channels * sizeof(f32));
+		if (!ret->noise) goto fail;
+		for (u32 i = 0; i < GAX_NOISE_LANES; i++) ret->noise_state[i] = 0x9e3779b9u * (i + 1);
+	}
+	if (m->num_threads > 1 && !ga_isok(gaX_mixer_start_workers(ret, m->num_threads - 1))) goto fail;
 	return ret;
 
 fail:
+	gaX_mixer_stop_workers(ret);
+	ga_free(ret->limiter);
+	ga_free(ret->noise);
+	ga_free(ret->mix_buffer);
 	ga_mutex_destroy(ret->handle_group.mutex);
 	ga_mutex_destroy(ret->dispatch_mutex);
-	ga_mutex_destroy(ret->mix_mutex);
+	ga_mutex_destroy(ret->scratch_mutex);
+	ga_mutex_destroy(ret->handles.mutex);
+	ga_semaphore_destroy(ret->wake);
 	ga_free(ret);
 	return NULL;
 }
 
+GaMixer *ga_mixer_create(GaFormat format, u32 num_frames) {
+	return ga_mixer_create_ext(&(GaMixerCreationMinutiae){.format = format, .num_frames = num_frames});
+}
+
 ga_result ga_mixer_suspend(GaMixer *m) {
 	return atomic_exchange(&m->suspended, true) ? GA_ERR_MIS_UNSUP : GA_OK;
 }
@@ -877,247 +1640,608 @@ u32 ga_mixer_num_frames(GaMixer *mixer) {
 	return mixer->num_frames;
 }
 
-static void gaX_mixer_mix_buffer(GaMixer *mixer,
-                                 void *src_buffer, s32 src_frames, GaFormat *src_fmt,
-                                 s32 *dst, s32 dst_frames, GaFormat *dst_fmt,
-                                 f32 gain, f32 last_gain, f32 pan, f32 last_pan, f32 pitch) {
-	u32 mixer_channels = dst_fmt->num_channels;
-	s32 src_channels = src_fmt->num_channels;
-	f32 sample_scale = 1 / pitch; //todo interpolate?
-	f32 fj = 0.0;
-	f32 srcSamplesRead = 0.0;
-	pan = clamp((pan + 1) / 2, 0, 1);
-	last_pan = clamp((last_pan + 1) / 2, 0, 1);
-	f32 cur_pan = last_pan, cur_gain = last_gain;
-	f32 d_pan = (pan - last_pan) / dst_frames;
-	f32 d_gain = (gain - last_gain) / dst_frames;
-	s32 src_bytes = src_frames * ga_format_frame_size(*src_fmt);
-
-	/* TODO: Support mono mixing format */
-	switch (src_fmt->sample_fmt) {
-		case GaSampleFormat_U8: {
-			const u8 *src = src_buffer;
-			for (u32 i = 0, j = 0; i < dst_frames * mixer_channels && src_bytes >= (s32)sizeof(u8) * src_channels; i += mixer_channels) {
-				f32 lmul = cur_gain * (cur_pan < 0.5 ? 1 : (1 - cur_pan) * 2);
-				f32 rmul = cur_gain * (cur_pan > 0.5 ? 1 : cur_pan * 2);
-				cur_pan += d_pan;
-				cur_gain += d_gain;
-				dst[i] += ga_trans_s16_of_u8(src[j]) * lmul;
-				dst[i + 1] += ga_trans_s16_of_u8(src[j + (src_channels > 1)]) * rmul;
-
-				fj += sample_scale * src_channels;
-				srcSamplesRead += sample_scale * src_channels;
-				u32 jP/*j'*/ = (u32)fj & (src_channels == 1 ? ~0u : ~1u);
-				src_bytes -= (jP - j) * sizeof(u8);
-				j = jP;
-			}
+u64 ga_mixer_frame(GaMixer *mixer) {
+	return atomic_load(&mixer->clock);
+}
 
-			break;
-		}
-		case GaSampleFormat_S16: {
-			const s16 *src = src_buffer;
-			for (u32 i = 0, j = 0; i < dst_frames * mixer_channels && src_bytes >= (s32)sizeof(s16) * src_channels; i += mixer_channels) {
-				f32 lmul = cur_gain * (cur_pan < 0.5 ? 1 : (1 - cur_pan) * 2);
-				f32 rmul = cur_gain * (cur_pan > 0.5 ? 1 : cur_pan * 2);
-				cur_pan += d_pan;
-				cur_gain += d_gain;
-				dst[i] += (s32)((s32)src[j] * lmul);
-				dst[i + 1] += (s32)((s32)src[j + (src_channels > 1)] * rmul);
-
-				fj += sample_scale * src_channels;
-				srcSamplesRead += sample_scale * src_channels;
-				u32 jP/*j'*/ = (u32)fj & (src_channels == 1 ? ~0u : ~1u);
-				src_bytes -= (jP - j) * sizeof(s16);
-				j = jP;
-			}
+u32 ga_mixer_latency(GaMixer *mixer) {
+	return mixer->limiter ? GAX_LIMITER_LOOKAHEAD : 0;
+}
 
-			break;
-		}
-		case GaSampleFormat_S32: {
-			const s32 *src = src_buffer;
-			for (u32 i = 0, j = 0; i < dst_frames * mixer_channels && src_bytes >= (s32)sizeof(s32) * src_channels; i += mixer_channels) {
-				f32 lmul = cur_gain * (cur_pan < 0.5 ? 1 : (1 - cur_pan) * 2);
-				f32 rmul = cur_gain * (cur_pan > 0.5 ? 1 : cur_pan * 2);
-				cur_pan += d_pan;
-				cur_gain += d_gain;
-				dst[i] += ga_trans_s16_of_s32(src[j] * lmul);
-				dst[i + 1] += ga_trans_s16_of_s32(src[j + (src_channels > 1)] * rmul);
-
-				fj += sample_scale * src_channels;
-				srcSamplesRead += sample_scale * src_channels;
-				u32 jP/*j'*/ = (u32)fj & (src_channels == 1 ? ~0u : ~1u);
-				src_bytes -= (jP - j) * sizeof(s32);
-				j = jP;
+// this thread's buffer for bus g, taking a cleared one from the pool the
+// first time it's used in a mix; 'out' if g isn't a bus
+static void *gaX_mixer_bus_buffer(GaMixer *m, GaHandleGroup *g, GaXMixScratch *scratch, void *out) {
+	if (!g || !g->is_bus) return out;
+	void **buf = &scratch->buses[g->bus_index];
+	if (!*buf) {
+		usz size = m->num_frames * ga_format_frame_size(m->mix_format);
+		*buf = (char*)m->bus_pool + atomic_fetch_add(&m->bus_pool_next, 1) * size;
+		memset(*buf, 0, size);
+	}
+	return *buf;
+}
+
+// should voice a be heard before voice b?
+static bool gaX_voice_before(const GaXVoiceTable *v, u32 a, u32 b) {
+	if (v->priority[a] != v->priority[b]) return v->priority[a] > v->priority[b];
+	if (v->gain[a] != v->gain[b]) return v->gain[a] > v->gain[b];
+	return v->play_stamp[a] < v->play_stamp[b];
+}
+
+// partially sort the n voices in r so that its first k entries are the k which should be heard
+static void gaX_voices_select(const GaXVoiceTable *v, u32 *r, u32 n, u32 k) {
+	u32 lo = 0, hi = n;
+	while (hi - lo > 1) {
+		u32 mid = lo + (hi - lo) / 2;
+		u32 t = r[mid]; r[mid] = r[hi - 1]; r[hi - 1] = t;
+		u32 pivot = r[hi - 1];
+		u32 store = lo;
+		for (u32 i = lo; i < hi - 1; i++) {
+			if (gaX_voice_before(v, r[i], pivot)) {
+				t = r[i]; r[i] = r[store]; r[store] = t;
+				store++;
 			}
-
-			break;
 		}
-		case GaSampleFormat_F32: {
-			const f32 *src = src_buffer;
-			for (u32 i = 0, j = 0; i < dst_frames * mixer_channels && src_bytes >= (s32)sizeof(f32) * src_channels; i += mixer_channels) {
-				f32 lmul = cur_gain * (cur_pan < 0.5 ? 1 : (1 - cur_pan) * 2);
-				f32 rmul = cur_gain * (cur_pan > 0.5 ? 1 : cur_pan * 2);
-				cur_pan += d_pan;
-				cur_gain += d_gain;
-				dst[i] += ga_trans_s16_of_f32(clamp(src[j] * lmul, -1, 1));
-				dst[i + 1] += ga_trans_s16_of_f32(clamp(src[j + (src_channels > 1)] * rmul, -1, 1));
-
-				fj += sample_scale * src_channels;
-				srcSamplesRead += sample_scale * src_channels;
-				u32 jP/*j'*/ = (u32)fj & (src_channels == 1 ? ~0u : ~1u);
-				src_bytes -= (jP - j) * sizeof(f32);
-				j = jP;
-			}
+		t = r[store]; r[store] = r[hi - 1]; r[hi - 1] = t;
+		if (store == k) return;
+		else if (store < k) lo = store + 1;
+		else hi = store;
+	}
+}
 
-			break;
-		}
+// Decide which playing handles are heard this buffer.  Virtual handles
+// aren't mixed, but keep their place in the source; see gaX_handle_skip.
+// Called with scratch_mutex held
+static void gaX_mixer_pick_voices(GaMixer *m) {
+	GaXVoiceTable *v = &m->voices;
+	u64 end = m->clock + m->num_frames;
+	u32 n = 0;
+	for (u32 i = 0; i < v->count; i++) {
+		v->is_virtual[i] = v->gain[i] < m->virtual_gain;
+		if (m->max_voices && !v->is_virtual[i] && v->state[i] == GaHandleState_Playing && v->start_frame[i] < end) v->ranked[n++] = i;
+	}
+	if (n <= m->max_voices) return;
+
+	gaX_voices_select(v, v->ranked, n, m->max_voices);
+	for (u32 i = m->max_voices; i < n; i++) v->is_virtual[v->ranked[i]] = true;
+}
+
+// advance virtual voice i by frames without decoding them, if its source allows
+static bool gaX_handle_skip(GaMixer *m, u32 i, usz frames) {
+	GaHandle *h = m->voices.handle[i];
+	GaSampleSource *ss = m->voices.src[i];
+	if (!(ga_sample_source_flags(ss) & GaDataAccessFlag_Seekable)) return false;
+	usz pos, total;
+	if (!ga_isok(ga_sample_source_tell(ss, &pos, &total))) return false;
+	// let the source reach its end normally, so the handle finishes on time
+	if (pos + atomic_load(&h->virtual_frames) + frames >= total) return false;
+	atomic_fetch_add(&h->virtual_frames, frames);
+	return true;
+}
+
+// seek past any frames skipped while the handle was virtual
+static void gaX_handle_catch_up(GaHandle *h) {
+	usz owed = atomic_exchange(&h->virtual_frames, 0);
+	if (!owed) return;
+	usz pos;
+	if (!ga_isok(ga_sample_source_tell(h->sample_src, &pos, NULL))
+	 || !ga_isok(ga_sample_source_seek(h->sample_src, pos + owed))) {
+		ga_trace("Couldn't catch up %zu frames skipped by a virtual handle", owed);
 	}
 }
 
-static void gaX_mixer_mix_handle(GaMixer *mixer, GaHandle *handle, usz num_frames) {
-	GaSampleSource *ss = handle->sample_src;
-	if (ga_sample_source_end(ss)) {
-		/* Stream is finished! */
-		ga_mutex_lock(handle->mutex);
-		if (handle->state < GaHandleState_Finished)
-			handle->state = GaHandleState_Finished;
-		ga_mutex_unlock(handle->mutex);
-		return;
+// mix num_frames frames of voice i into the output, from frame 'offset' of it on
+static void gaX_mixer_mix_voice_frames(GaMixer *mixer, u32 i, usz offset, usz num_frames, void *mix_buffer, GaXMixScratch *scratch) {
+	GaXVoiceTable *v = &mixer->voices;
+	GaSampleSource *ss = v->src[i];
+	GaFormat handle_format = v->format[i];
+	usz frame_size = ga_format_frame_size(handle_format);
+	GaXResampleState *rs = &v->resample[i];
+	f32 *matrix = v->matrix[i].m, *last_matrix = v->last_matrix[i].m;
+	// Source frames per mixed frame: the rate conversion and the pitch
+	// together, so every handle is interpolated once at most.  At exactly 1,
+	// frames are mixed as they're read; otherwise they're interpolated on
+	// the way into the mix, picking up from where the last mix left off.
+	// A change of step ramps over the mix, as gain and pan do, and coming
+	// back to 1 from elsewhere carries on from the history if it lines up
+	f64 step = (f64)handle_format.frame_rate / mixer->format.frame_rate * clamp(v->pitch[i], 0, mixer->max_pitch);
+	f64 last_step = rs->step ? rs->step : step;
+	f64 d_step = (step - last_step) / num_frames;
+	rs->step = step;
+	bool interpolate = step != 1 || last_step != 1 || (rs->primed && (rs->phase || num_frames < 2));
+
+	/* Scratch was sized for this handle when it was created */
+	u8 *src = scratch->src;
+	usz have = 0;
+	f64 pos = 0;
+	if (rs->primed) {
+		memcpy(src, rs->history, 2 * frame_size);
+		have = 2;
+		pos = rs->phase;
 	}
-	if (handle->state != GaHandleState_Playing) return;
-	GaFormat handle_format = ga_sample_source_format(ss);
-	/* Check if we have enough frames to stream a full buffer */
-	f32 old_pitch = *handle_get_paramf(handle, GaXHandleParam_Pitch);
-	// number of frames to mix (after resampling)
-	usz needed = num_frames / old_pitch;
-	needed = (needed * old_pitch < num_frames) ? needed + 1 : needed;
+	// how far this mix moves through the source
+	usz advance = interpolate ? (usz)gaX_resample_pos(pos, last_step, d_step, num_frames) : num_frames;
 	// number of frames to request from the handle
-	usz requested = handle->resample_state ? ga_trans_resample_howmany(handle->resample_state, needed) : needed;
+	usz requested = (interpolate ? advance + 2 : advance) - have;
+	assert((have + requested) * frame_size <= scratch->src_size);
+
+	if (v->is_virtual[i]) {
+		// fade back in from silence once it's heard again
+		memset(last_matrix, 0, sizeof(GaXMixMatrix));
+		if (gaX_handle_skip(mixer, i, requested)) {
+			// Move on exactly as playing would have, so that the handle is
+			// in step when it's heard again.  The history isn't read, but
+			// it's only heard at the start of the fade in, from silence
+			if (!interpolate) {
+				rs->primed = false;
+				return;
+			}
+			if (!rs->primed) {
+				gaX_silence(rs->history, 2, handle_format);
+				rs->silent = true;
+			}
+			rs->phase = gaX_resample_pos(pos, last_step, d_step, num_frames) - advance;
+			rs->primed = true;
+			return;
+		}
+	}
+	gaX_handle_catch_up(v->handle[i]);
 
 	if (!ga_sample_source_ready(ss, requested)) {
 		ga_trace("Sample source not ready to play %zu frames; skipped!", requested);
 		return;
 	}
 
-	ga_mutex_lock(handle->mutex);
-	f32 gain = *handle_get_paramf(handle, GaXHandleParam_Gain);
-	f32 last_gain = *handle_get_paramf(handle, GaXHandleParam_LastGain);
-	*handle_get_paramf(handle, GaXHandleParam_LastGain) = gain;
+	// frames the source knows are silent needn't be read, and if that's all
+	// there is to mix, needn't be mixed either.  Silence in src runs from
+	// quiet_from up to have + silent
+	usz silent = ga_sample_source_skip_silence(ss, requested);
+	usz quiet_from = have && !(rs->primed && rs->silent) ? have : 0;
+	gaX_silence(src + have * frame_size, silent, handle_format);
+	usz num_read = silent;
+	if (silent < requested) num_read += ga_sample_source_read(ss, src + (have + silent) * frame_size, requested - silent, NULL, NULL);
+	usz got = have + num_read;
+
+	usz frames = num_frames;
+	if (interpolate) {
+		if (got >= advance + 2) {
+			memcpy(rs->history, src + advance * frame_size, 2 * frame_size);
+			rs->phase = gaX_resample_pos(pos, last_step, d_step, num_frames) - advance;
+			rs->primed = true;
+			rs->silent = advance >= quiet_from && advance + 2 <= have + silent;
+		} else {
+			// the source ran out; only mix the frames with a frame either
+			// side, of which there are however many land before frame got - 1
+			usz lo = 0, hi = num_frames;
+			while (lo < hi) {
+				usz mid = lo + (hi - lo) / 2;
+				if (gaX_resample_pos(pos, last_step, d_step, mid) < (f64)got - 1) lo = mid + 1;
+				else hi = mid;
+			}
+			frames = lo;
+			rs->primed = false;
+		}
+	} else {
+		frames = min(num_frames, got);
+		rs->primed = false;
+	}
+	// couldn't skip ahead, so the frames were read only to be dropped
+	if (v->is_virtual[i]) return;
+	if (!frames) return;
+	if (!quiet_from && num_read == silent) {
+		v->last_matrix[i] = v->matrix[i];
+		return;
+	}
 
-	f32 pan = *handle_get_paramf(handle, GaXHandleParam_Pan);
-	f32 last_pan = *handle_get_paramf(handle, GaXHandleParam_LastPan);
-	*handle_get_paramf(handle, GaXHandleParam_LastPan) = pan;
+	u32 src_channels = handle_format.num_channels;
+	u32 dst_channels = mixer->mix_format.num_channels;
+	f32 d_mat[GAX_MAX_CHANNELS * GAX_MAX_CHANNELS];
+	for (u32 k = 0; k < src_channels * dst_channels; k++) d_mat[k] = (matrix[k] - last_matrix[k]) / num_frames;
+
+	u32 bus = gaX_mix_bus_index(mixer->mix_format.sample_fmt);
+	u32 fmt = gaX_sample_format_index(handle_format.sample_fmt);
+	u32 layout = gaX_mix_layout_index(src_channels, dst_channels);
+	u8 *out = (u8*)gaX_mixer_bus_buffer(mixer, v->group[i], scratch, mix_buffer) + offset * ga_format_frame_size(mixer->mix_format);
+	if (interpolate) mixer->kernels->resample[bus][fmt][layout](out, src, frames, pos, last_step, d_step, last_matrix, d_mat, src_channels, dst_channels);
+	else mixer->kernels->mix[bus][fmt][layout](out, src, frames, last_matrix, d_mat, src_channels, dst_channels);
+	v->last_matrix[i] = v->matrix[i];
+}
+
+// set a handle's state from the mix thread, in its row and on the handle itself
+static void gaX_mixer_set_state(GaMixer *m, u32 i, GaHandleState from, GaHandleState to) {
+	GaHandle *h = m->voices.handle[i];
+	with_mutex(h->mutex) {
+		if (h->state >= from && h->state < to) h->state = to;
+		m->voices.state[i] = h->state;
+	}
+}
 
-	f32 pitch = *handle_get_paramf(handle, GaXHandleParam_Pitch);
-	ga_mutex_unlock(handle->mutex);
+static void gaX_mixer_mix_voice(GaMixer *mixer, u32 i, usz num_frames, void *mix_buffer, GaXMixScratch *scratch) {
+	GaXVoiceTable *v = &mixer->voices;
+	if (ga_sample_source_end(v->src[i])) {
+		/* Stream is finished! */
+		gaX_mixer_set_state(mixer, i, GaHandleState_Unknown, GaHandleState_Finished);
+		return;
+	}
+	if (v->state[i] != GaHandleState_Playing) return;
+
+	// only the part of this mix between the handle's scheduled start and
+	// stop is played; see ga_handle_play_at
+	u64 now = atomic_load(&mixer->clock);
+	u64 start = v->start_frame[i];
+	u64 stop = v->stop_frame[i];
+	usz from = start > now ? min(start - now, num_frames) : 0;
+	usz to = stop > now ? min(stop - now, num_frames) : 0;
+	if (from < to) gaX_mixer_mix_voice_frames(mixer, i, from, to - from, mix_buffer, scratch);
+
+	if (stop < now + num_frames) {
+		gaX_mixer_set_state(mixer, i, GaHandleState_Playing, GaHandleState_Stopped);
+		// unless it's been rescheduled meanwhile
+		atomic_compare_exchange_strong(&v->handle[i]->stop_frame, &stop, UINT64_MAX);
+		v->stop_frame[i] = UINT64_MAX;
+	}
+}
 
-	/* We avoided a mutex lock by using pitch to check if buffer has enough dst frames */
-	/* If it has changed since then, we re-test to make sure we still have enough frames */
-	if (old_pitch != pitch) {
-		needed = num_frames / pitch;
-		needed = needed * pitch < num_frames ? needed + 1 : needed;
-		requested = handle->resample_state ? ga_trans_resample_howmany(handle->resample_state, needed) : needed;
-		if (!ga_sample_source_ready(ss, requested)) {
-			ga_trace("Sample source not ready to play %zu frames; skipped!", requested);
-			return;
+// Hold the master bus's peaks under the ceiling, delaying it by the
+// lookahead so the gain can come down smoothly ahead of a peak.  The gain
+// each frame needs is held for the lookahead (a sliding minimum), allowed
+// back up gradually, then averaged over the lookahead.  Every frame a
+// frame goes out with is averaged from gains no higher than it needs, so
+// nothing passes the ceiling; the attack is a ramp over the lookahead
+static void gaX_mixer_limit(GaMixer *m) {
+	GaXLimiter *l = m->limiter;
+	const u32 L = GAX_LIMITER_LOOKAHEAD, n = m->num_frames, nc = m->mix_format.num_channels;
+	const usz frame_size = ga_format_frame_size(m->mix_format);
+	const u32 bus = gaX_mix_bus_index(m->mix_format.sample_fmt);
+	char *delay = l->delay;
+
+	memcpy(delay + L * frame_size, m->mix_buffer, n * frame_size);
+	m->kernels->peaks[bus](l->peaks, m->mix_buffer, n, nc);
+
+	// summing afresh each time stops rounding errors piling up
+	f32 sum = 0;
+	for (u32 i = 0; i <= L; i++) sum += l->held[i];
+	f32 last = l->held[(l->held_pos + L) % (L + 1)];
+	for (u32 i = 0; i < n; i++) {
+		u32 t = l->frame++;
+		f32 need = l->peaks[i] > l->ceiling ? l->ceiling / l->peaks[i] : 1;
+		if (l->min_count && t - l->min_frame[l->min_head] > L) {
+			l->min_head = (l->min_head + 1) % (L + 1);
+			l->min_count--;
 		}
+		while (l->min_count && l->min_gain[(l->min_head + l->min_count - 1) % (L + 1)] >= need) l->min_count--;
+		u32 back = (l->min_head + l->min_count++) % (L + 1);
+		l->min_gain[back] = need;
+		l->min_frame[back] = t;
+
+		f32 hold = l->min_gain[l->min_head];
+		if (hold > last) hold = last + (hold - last) * l->release;
+		last = hold;
+		sum += hold - l->held[l->held_pos];
+		l->held[l->held_pos] = hold;
+		l->held_pos = (l->held_pos + 1) % (L + 1);
+		l->gains[i] = sum / (L + 1);
+	}
+
+	m->kernels->gain[bus](delay, l->gains, n, nc);
+	memcpy(m->mix_buffer, delay, n * frame_size);
+	memmove(delay, delay + n * frame_size, L * frame_size);
+}
+
+// the only place the mix is clipped
+static void gaX_mixer_convert(GaMixer *m, void *buffer) {
+	usz n = m->num_frames * m->format.num_channels, lag = m->format.num_channels;
+	GaXCbMixConvert convert = m->kernels->convert[gaX_mix_bus_index(m->mix_format.sample_fmt)][gaX_sample_format_index(m->format.sample_fmt)];
+	if (!m->noise) {
+		convert(buffer, m->mix_buffer, n, NULL, lag);
+		return;
+	}
+
+	// keep the last frame's noise in front of this one's, for the high-pass
+	m->kernels->noise(m->noise + lag, n, m->noise_state);
+	convert(buffer, m->mix_buffer, n, m->noise, lag);
+	memmove(m->noise, m->noise + n, lag * sizeof(f32));
+}
+
+// pick up changes posted by gaX_handle_post, unless they're being held back
+// (see gaX_mixer_hold).  Called with scratch_mutex held
+static void gaX_mixer_drain_params(GaMixer *m) {
+	// either the hold sees draining set and waits for this drain, or this
+	// sees the hold
+	atomic_store(&m->draining, true);
+	if (atomic_load(&m->holds)) {
+		atomic_store(&m->held_off, true);
+		atomic_store(&m->draining, false);
+		return;
 	}
+	atomic_store(&m->held_off, false);
+	GaHandle *h = atomic_exchange(&m->dirty_handles, NULL);
+	while (h) {
+		// once dirty is clear, h may be queued again, which clobbers next_dirty
+		GaHandle *next = h->next_dirty;
+		atomic_store(&h->dirty, false);
+		// handles without a row yet get one with their current values anyway
+		u32 i = atomic_load(&h->voice);
+		if (i != GAX_NO_VOICE) gaX_mixer_load_voice(m, i);
+		h = next;
+	}
+	atomic_fetch_add(&m->drains, 1);
+	atomic_store(&m->draining, false);
+}
+
+// swap-remove the rows of finished handles, and let dispatch know.  Called
+// with scratch_mutex held
+static void gaX_mixer_retire_voices(GaMixer *m) {
+	GaXVoiceTable *v = &m->voices;
+	for (u32 i = v->count; i-- > 0;) {
+		if (v->state[i] < GaHandleState_Finished) continue;
+		GaHandle *h = v->handle[i];
+		atomic_store(&h->voice, GAX_NO_VOICE);
+		// the finish event has to be queued before ga_handle_destroy can queue cleanup
+		gaX_mixer_push_event(m, &h->finish_event);
+		if (atomic_fetch_or(&h->done, GaXHandleDone_Retired) == GaXHandleDone_Destroyed) gaX_mixer_push_event(m, &h->cleanup_event);
+		u32 last = --v->count;
+		if (i == last) continue;
+#define GAX_VOICE_FIELD(type, name) v->name[i] = v->name[last];
+		GAX_VOICE_FIELDS(GAX_VOICE_FIELD)
+#undef GAX_VOICE_FIELD
+		atomic_store(&v->handle[i]->voice, i);
+	}
+}
+
+static bool gaX_mixer_any_playing(GaMixer *m) {
+	for (u32 i = 0; i < m->voices.count; i++) {
+		if (m->voices.state[i] == GaHandleState_Playing) return true;
+	}
+	return false;
+}
 
-	void *dst = ga_alloc(needed * ga_format_frame_size(handle_format));
-	if (mixer->format.frame_rate != handle_format.frame_rate) {
-		void *src = ga_alloc(requested * ga_format_frame_size(handle_format));
-		usz num_read = ga_sample_source_read(ss, src, requested, NULL, NULL);
-		if (num_read != requested) {
-			f32 r = needed / (f32)requested;
-			requested = num_read;
-			needed = requested * r;
+static void gaX_mixer_mix_voices(GaMixer *m, u32 first, u32 count, void *mix_buffer, GaXMixScratch *scratch) {
+	for (u32 i = first; i < first + count; i++) {
+		gaX_mixer_mix_voice(m, i, m->num_frames, mix_buffer, scratch);
+	}
+}
+
+static ga_result gaX_mix_worker(void *context) {
+	GaXMixWorker *w = context;
+	GaMixer *m = w->mixer;
+	while (true) {
+		ga_semaphore_wait(w->start);
+		if (w->quit) return GA_OK;
+
+		gaX_realtime_enter();
+		memset(w->mix_buffer, 0, m->num_frames * ga_format_frame_size(m->mix_format));
+		gaX_mixer_mix_voices(m, w->first, w->count, w->mix_buffer, &w->scratch);
+		gaX_realtime_leave();
+		ga_semaphore_post(m->workers_done);
+	}
+}
+
+// Split the voice table into contiguous runs, one per thread, with the
+// caller taking the first.  The split only depends on the number of voices,
+// and the partial mixes are summed in order, so the result is deterministic.
+// Called with scratch_mutex held, so the table doesn't change underneath
+static void gaX_mixer_mix_parallel(GaMixer *m) {
+	u32 n = m->voices.count;
+	u32 nt = m->num_workers + 1;
+	u32 own = n / nt + (0 < n % nt);
+	u32 first = own;
+	for (u32 t = 1; t < nt; t++) {
+		GaXMixWorker *w = &m->workers[t - 1];
+		w->first = first;
+		w->count = n / nt + (t < n % nt);
+		first += w->count;
+		ga_semaphore_post(w->start);
+	}
+
+	gaX_mixer_mix_voices(m, 0, own, m->mix_buffer, &m->scratch);
+
+	usz len = m->num_frames * m->mix_format.num_channels;
+	GaXCbMixAdd add = m->kernels->add[gaX_mix_bus_index(m->mix_format.sample_fmt)];
+	for (u32 t = 0; t < m->num_workers; t++) ga_semaphore_wait(m->workers_done);
+	for (u32 t = 0; t < m->num_workers; t++) add(m->mix_buffer, m->workers[t].mix_buffer, len);
+}
+
+// scale a bus by a gain ramped from 'from' to 'to' over the mix
+static void gaX_mixer_bus_gain(GaMixer *m, void *buf, f32 from, f32 to) {
+	if (from == 1 && to == 1) return;
+	u32 nc = m->mix_format.num_channels;
+	f32 d = (to - from) / m->num_frames;
+	if (m->mix_format.sample_fmt == GaSampleFormat_F32) {
+		f32 *b = buf;
+		for (u32 i = 0; i < m->num_frames; i++) {
+			f32 g = from + i * d;
+			for (u32 c = 0; c < nc; c++) b[i * nc + c] *= g;
 		}
-		ga_trans_resample_linear(handle->resample_state, dst, needed, src, requested);
-		//ga_trans_resample_point(handle->resample_state, dst, needed, src, requested);
-		ga_free(src);
 	} else {
-		usz num_read = ga_sample_source_read(ss, dst, needed, NULL, NULL);
-
-		if (num_read != requested) {
-			f32 r = needed / (f32)requested;
-			requested = num_read;
-			needed = requested * r;
+		s32 *b = buf;
+		for (u32 i = 0; i < m->num_frames; i++) {
+			f32 g = from + i * d;
+			for (u32 c = 0; c < nc; c++) b[i * nc + c] = clamp(b[i * nc + c] * g, -2147483648.f, 2147483520.f);
 		}
 	}
+}
+
+// Run the bus tree bottom-up: gather each bus's partial mixes from every
+// thread, apply its gain and effect, and mix it into its parent.  Buses
+// nothing was mixed into are skipped
+static void gaX_mixer_mix_buses(GaMixer *m) {
+	usz len = m->num_frames * m->mix_format.num_channels;
+	GaXCbMixAdd add = m->kernels->add[gaX_mix_bus_index(m->mix_format.sample_fmt)];
+	for (u32 b = 0; b < m->num_buses; b++) {
+		GaHandleGroup *g = m->buses[b];
+		void *buf = m->scratch.buses[b];
+		m->scratch.buses[b] = NULL;
+		for (u32 t = 0; t < m->num_workers; t++) {
+			void **part = &m->workers[t].scratch.buses[b];
+			if (!*part) continue;
+			if (buf) add(buf, *part, len);
+			else buf = *part;
+			*part = NULL;
+		}
 
-	gaX_mixer_mix_buffer(mixer,
-	                     dst, needed, &handle_format,
-	                     mixer->mix_buffer, num_frames, &mixer->format,
-	                     gain, last_gain, pan, last_pan, pitch);
-	ga_free(dst);
+		f32 gain = atomic_load(&g->bus_gain);
+		if (buf) {
+			gaX_mixer_bus_gain(m, buf, g->last_bus_gain, gain);
+			if (g->effect) g->effect(g->effect_context, buf, m->num_frames, &m->mix_format);
+			add(gaX_mixer_bus_buffer(m, g->parent, &m->scratch, m->mix_buffer), buf, len);
+		}
+		g->last_bus_gain = gain;
+	}
+	atomic_store(&m->bus_pool_next, 0);
 }
 
 void ga_mixer_mix(GaMixer *m, void *buffer) {
 	if (m->suspended) {
-		memset(buffer, 0, m->num_frames * ga_format_frame_size(m->format));
+		with_mutex(m->scratch_mutex) gaX_mixer_drain_params(m);
+		gaX_silence(buffer, m->num_frames, m->format);
+		atomic_fetch_add(&m->clock, m->num_frames);
 		return;
 	}
 
-	memset(m->mix_buffer, 0, m->num_frames * ga_format_frame_size(m->mix_format));
+	gaX_realtime_enter();
+	u64 t0 = gaX_time_ns();
+	bool idle;
+
+	with_mutex(m->scratch_mutex) {
+		gaX_mixer_drain_params(m);
+		bool playing = gaX_mixer_any_playing(m);
+		m->quiet_frames = playing ? 0 : m->quiet_frames + m->num_frames;
+		// with nothing playing, and the limiter's delay flushed by the mixes
+		// before, the mix is all silence; only the end checks, and the bus
+		// gain ramps (over empty buses), are left to do
+		idle = !playing && m->quiet_frames >= m->num_frames + ga_mixer_latency(m);
+		if (idle) {
+			gaX_mixer_mix_voices(m, 0, m->voices.count, NULL, &m->scratch);
+			if (m->limiter) gaX_limiter_reset(m->limiter);
+		} else {
+			memset(m->mix_buffer, 0, m->num_frames * ga_format_frame_size(m->mix_format));
+			gaX_mixer_pick_voices(m);
+			if (m->num_workers) gaX_mixer_mix_parallel(m);
+			else gaX_mixer_mix_voices(m, 0, m->voices.count, m->mix_buffer, &m->scratch);
+		}
+		gaX_mixer_mix_buses(m);
+		gaX_mixer_retire_voices(m);
+	}
+	atomic_store(&m->idle, idle);
 
+	u64 t1 = t0, t2 = t0;
+	if (idle) {
+		gaX_silence(buffer, m->num_frames, m->format);
+		atomic_fetch_add_explicit(&m->stat_idle_mixes, 1, memory_order_relaxed);
+	} else {
+		if (m->limiter) gaX_mixer_limit(m);
+		t1 = gaX_time_ns();
+		gaX_mixer_convert(m, buffer);
+		t2 = gaX_time_ns();
+	}
+	atomic_fetch_add(&m->clock, m->num_frames);
+	atomic_fetch_add_explicit(&m->stat_mixes, 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&m->stat_mix_ns, t2 - t0, memory_order_relaxed);
+	atomic_fetch_add_explicit(&m->stat_convert_ns, t2 - t1, memory_order_relaxed);
+	gaX_realtime_leave();
+}
+
+GaMixerStats ga_mixer_stats(GaMixer *m) {
+	return (GaMixerStats){
+		.mixes = atomic_load_explicit(&m->stat_mixes, memory_order_relaxed),
+		.mix_ns = atomic_load_explicit(&m->stat_mix_ns, memory_order_relaxed),
+		.convert_ns = atomic_load_explicit(&m->stat_convert_ns, memory_order_relaxed),
+		.idle_mixes = atomic_load_explicit(&m->stat_idle_mixes, memory_order_relaxed),
+	};
+}
+
+void ga_mixer_wait(GaMixer *m) {
+	atomic_store(&m->waiting, true);
+	// anything posted before waiting was set is already in dirty_handles;
+	// anything after will see it, and wake us
+	if (!atomic_load(&m->idle) || atomic_load(&m->dirty_handles)) {
+		// unless someone took the wakeup meant for us; then it's owed on the semaphore
+		if (atomic_exchange(&m->waiting, false)) return;
+	}
+	ga_semaphore_wait(m->wake);
+}
 
-	ga_list_iterate(GaHandle, h, &m->mix_list) {
-		gaX_mixer_mix_handle(m, h, m->num_frames);
-		if (ga_handle_finished(h)) {
-			with_mutex(m->mix_mutex) ga_list_unlink(link);
-		}
+void ga_mixer_wake(GaMixer *m) {
+	atomic_store(&m->idle, false);
+	if (atomic_exchange(&m->waiting, false)) ga_semaphore_post(m->wake);
+}
+
+ga_result ga_mixer_render(GaMixer *m, GaStreamManager *streams, void *dst, usz num_frames) {
+	usz frame_size = ga_format_frame_size(m->format);
+	// render_left is only ever set once the buffer's there
+	if (!m->render_buffer && num_frames % m->num_frames) {
+		m->render_buffer = ga_alloc(m->num_frames * frame_size);
+		if (!m->render_buffer) return GA_ERR_SYS_MEM;
 	}
 
-	/* mix_buffer will already be correct bps */
-	switch (m->format.sample_fmt) {
-		case GaSampleFormat_U8:
-			for (usz i = 0; i < m->num_frames * m->format.num_channels; i++) {
-				s16 sample = clamp(m->mix_buffer[i], -32768, 32767);
-				((u8*)buffer)[i] = ga_trans_u8_of_s16(sample);
-			}
-			break;
-		case GaSampleFormat_S16:
-			for (usz i = 0; i < m->num_frames * m->format.num_channels; i++) {
-				s16 sample = clamp(m->mix_buffer[i], -32768, 32767);
-			        ((s16*)buffer)[i] = sample;
-			}
-			break;
-		case GaSampleFormat_S32:
-			for (usz i = 0; i < m->num_frames * m->format.num_channels; i++) {
-				s16 sample = clamp(m->mix_buffer[i], -32768, 32767);
-				((s32*)buffer)[i] = ga_trans_s32_of_s16(sample);
-			}
-			break;
-		case GaSampleFormat_F32:
-			for (usz i = 0; i < m->num_frames * m->format.num_channels; i++) {
-				s16 sample = clamp(m->mix_buffer[i], -32768, 32767);
-				((f32*)buffer)[i] = ga_trans_f32_of_s16(sample);
-			}
-			break;
-		default: ga_err("bad sample format %d??", m->format.sample_fmt);
+	char *out = dst;
+	while (num_frames) {
+		if (m->render_left) {
+			usz n = min(num_frames, m->render_left);
+			memcpy(out, (char*)m->render_buffer + (m->num_frames - m->render_left) * frame_size, n * frame_size);
+			m->render_left -= n;
+			out += n * frame_size;
+			num_frames -= n;
+			continue;
+		}
+
+		if (streams) ga_stream_manager_buffer(streams);
+		if (num_frames >= m->num_frames) {
+			ga_mixer_mix(m, out);
+			out += m->num_frames * frame_size;
+			num_frames -= m->num_frames;
+		} else {
+			ga_mixer_mix(m, m->render_buffer);
+			m->render_left = m->num_frames;
+		}
 	}
+	return GA_OK;
 }
 
 void ga_mixer_dispatch(GaMixer *m) {
-	ga_list_iterate (GaHandle, handle, &m->dispatch_list) {
-		/* Remove finished handles and call callbacks */
-		if (ga_handle_destroyed(handle)) {
-			if (!handle->mix_link.next) {
-				/* NOTES ABOUT THREADING POLICY WITH REGARD TO LINKED LISTS: */
-				/* Only a single thread may iterate through any list */
-				/* The thread that unlinks must be the only thread that iterates through the list */
-				/* A single auxiliary thread may link(), but must mutex-lock to avoid link/unlink collisions */
-				ga_mutex_lock(m->dispatch_mutex);
-				ga_list_unlink(&handle->dispatch_link);
-				ga_mutex_unlock(m->dispatch_mutex);
-				gaX_handle_cleanup(handle);
+	// events come off the stack newest first; put them back in order, so a
+	// handle's finish event is seen before its cleanup
+	GaXHandleEvent *ev = atomic_exchange(&m->events, NULL), *queue = NULL;
+	while (ev) {
+		GaXHandleEvent *next = ev->next;
+		ev->next = queue;
+		queue = ev;
+		ev = next;
+	}
+
+	while ((ev = queue)) {
+		queue = ev->next;
+		GaHandle *handle = ev->handle;
+		if (ev == &handle->finish_event) {
+			/* Call callbacks */
+			handle->finish_dispatched = true;
+			if (handle->callback && !(atomic_load(&handle->done) & GaXHandleDone_Destroyed)) {
+				handle->callback(handle, handle->context);
+				handle->callback = NULL;
+				handle->context = NULL;
 			}
-		} else if (handle->callback && ga_handle_finished(handle)) {
-			handle->callback(handle, handle->context);
-			handle->callback = NULL;
-			handle->context = NULL;
+		} else {
+			/* The handle may still be on the mixer's dirty list.  Once it's out */
+			/* of its group, nothing can queue it again; after that, wait for the */
+			/* mixer to start (and finish) a fresh drain before freeing it */
+			if (handle->group_link.next) with_mutex(handle->group->mutex) ga_list_unlink(&handle->group_link);
+			handle->drain_epoch = atomic_load(&m->drains);
+			handle->next_limbo = m->limbo;
+			m->limbo = handle;
 		}
 	}
+
+	for (GaHandle **p = &m->limbo; *p;) {
+		GaHandle *handle = *p;
+		if (atomic_load(&m->drains) - handle->drain_epoch < 2) {
+			p = &handle->next_limbo;
+			continue;
+		}
+		*p = handle->next_limbo;
+		with_mutex(m->dispatch_mutex) ga_list_unlink(&handle->dispatch_link);
+		gaX_handle_cleanup(handle);
+	}
 }
 
 void ga_mixer_destroy(GaMixer *m) {
@@ -1130,8 +2254,22 @@ void ga_mixer_destroy(GaMixer *m) {
 
 
 	ga_mutex_destroy(m->dispatch_mutex);
-	ga_mutex_destroy(m->mix_mutex);
+	ga_mutex_destroy(m->scratch_mutex);
+	ga_mutex_destroy(m->handles.mutex);
+	ga_semaphore_destroy(m->wake);
+	for (u32 i = 0; i < m->handles.num_pages; i++) {
+		for (u32 j = 0; j < GAX_HANDLE_PAGE_SIZE; j++) ga_mutex_destroy(m->handles.pages[i][j].mutex);
+		ga_free(m->handles.pages[i]);
+	}
 
+	gaX_mixer_stop_workers(m);
+	ga_free(m->scratch.src);
+	ga_free(m->voices.block);
+	ga_free(m->buses);
+	ga_free(m->bus_pool);
+	ga_free(m->limiter);
+	ga_free(m->noise);
+	ga_free(m->render_buffer);
 	ga_free(m->mix_buffer);
 	ga_free(m);
 }
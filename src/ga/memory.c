@@ -134,7 +134,7 @@ void ga_list_unlink(GaLink *link) {
 	link->data = NULL;
 }
 void ga_list_merge(GaLink *dst, GaLink *src) {
-	if (src->next->prev == src) return;
+	if (src->next == src) return;
 
 	src->prev->next = dst->next;
 	dst->next->prev = src->prev;
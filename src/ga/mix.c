@@ -0,0 +1,1321 @@
+#include "gorilla/ga.h"
+#include "gorilla/ga_internal.h"
+
+#include <string.h>
+#include <math.h>
+
+// Mix kernels.  The scalar versions are the reference implementation; the
+// vector versions perform the same floating-point operations in the same
+// order, so their output is bit-identical to it on x86.  (On ARM, NEON
+// saturates instead of wrapping when a product overflows s32, which the
+// reference leaves undefined anyway.)
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+# define GAX_X86
+# include <immintrin.h>
+# define GAX_TARGET(isa) __attribute__((target(isa)))
+#elif defined(__ARM_NEON)
+# define GAX_NEON
+# include <arm_neon.h>
+#endif
+
+// raw sample loaders; the result is scaled to the bus by SCALE()
+static inline f32 load_u8(const u8 *s)   { return (s32)*s - 128; }
+static inline f32 load_s16(const s16 *s) { return *s; }
+static inline f32 load_s32(const s32 *s) { return *s; }
+static inline f32 load_f32(const f32 *s) { return *s; }
+
+#define FMT_u8  GaSampleFormat_U8
+#define FMT_s16 GaSampleFormat_S16
+#define FMT_s32 GaSampleFormat_S32
+#define FMT_f32 GaSampleFormat_F32
+#define SCALE(bus, T) gaX_mix_scale(FMT_ ## bus, FMT_ ## T)
+
+#define ACC_s32(d, x) ((d) += (s32)(x))
+#define ACC_f32(d, x) ((d) += (x))
+
+#ifdef __GNUC__
+# define GAX_INLINE inline __attribute__((always_inline))
+#else
+# define GAX_INLINE inline
+#endif
+
+// K(bus, T, ...) for every source format
+#define FORMATS(K, bus, ...) \
+	K(bus, u8, __VA_ARGS__) K(bus, s16, __VA_ARGS__) K(bus, s32, __VA_ARGS__) K(bus, f32, __VA_ARGS__)
+// K(bus, T, nsrc, ndst) for both buses and every source format
+#define LAYOUT_KERNELS(nsrc, ndst, K) FORMATS(K, s32, nsrc, ndst) FORMATS(K, f32, nsrc, ndst)
+
+// Frames [i, frames), for any layout.  Each output sample sums the source
+// channels in order, starting from channel 0.  The layout kernels pass
+// constant channel counts for the compiler to specialize on, and the vector
+// kernels finish off their tails with it
+#define SCALAR_FRAMES(bus, T, ...) \
+static GAX_INLINE void mix_frames_ ## bus ## _ ## T(bus *dst, const T *src, u32 i, u32 frames, const f32 *mat, const f32 *d_mat, u32 nsrc, u32 ndst) { \
+	const f32 scale = SCALE(bus, T); \
+	for (; i < frames; i++) { \
+		for (u32 d = 0; d < ndst; d++) { \
+			f32 x = load_ ## T(&src[nsrc*i]) * scale * (mat[d] + i * d_mat[d]); \
+			for (u32 s = 1; s < nsrc; s++) \
+				x += load_ ## T(&src[nsrc*i + s]) * scale * (mat[s*ndst + d] + i * d_mat[s*ndst + d]); \
+			ACC_ ## bus(dst[ndst*i + d], x); \
+		} \
+	} \
+} \
+static void mix_scalar_ ## bus ## _ ## T ## _generic(void *dst, const void *src, u32 frames, const f32 *mat, const f32 *d_mat, u32 src_channels, u32 dst_channels) { \
+	mix_frames_ ## bus ## _ ## T(dst, src, 0, frames, mat, d_mat, src_channels, dst_channels); \
+}
+FORMATS(SCALAR_FRAMES, s32, _)
+FORMATS(SCALAR_FRAMES, f32, _)
+#undef SCALAR_FRAMES
+
+#define SCALAR_KERNEL(bus, T, nsrc, ndst) \
+static void mix_scalar_ ## bus ## _ ## T ## _ ## nsrc ## _ ## ndst(void *dst, const void *src, u32 frames, const f32 *mat, const f32 *d_mat, u32 src_channels, u32 dst_channels) { \
+	mix_frames_ ## bus ## _ ## T(dst, src, 0, frames, mat, d_mat, nsrc, ndst); \
+}
+GAX_MIX_LAYOUTS(LAYOUT_KERNELS, SCALAR_KERNEL)
+#undef SCALAR_KERNEL
+
+// Interpolating kernels, for handles whose source moves at some other rate
+// than the mix.  Each source channel is interpolated once per frame, and
+// then goes through the matrix as above.  Only scalar; every kernel set
+// shares them
+#define SCALAR_RESAMPLE_FRAMES(bus, T, ...) \
+static GAX_INLINE void resample_frames_ ## bus ## _ ## T(bus *dst, const T *src, u32 frames, f64 pos, f64 step, f64 d_step, const f32 *mat, const f32 *d_mat, u32 nsrc, u32 ndst) { \
+	const f32 scale = SCALE(bus, T); \
+	f32 v[GAX_MAX_CHANNELS]; \
+	for (u32 i = 0; i < frames; i++) { \
+		f64 x = gaX_resample_pos(pos, step, d_step, i); \
+		usz j = (usz)x; \
+		f32 t = (f32)(x - j); \
+		for (u32 s = 0; s < nsrc; s++) { \
+			f32 a = load_ ## T(&src[nsrc*j + s]), b = load_ ## T(&src[nsrc*(j + 1) + s]); \
+			v[s] = (a + (b - a) * t) * scale; \
+		} \
+		for (u32 d = 0; d < ndst; d++) { \
+			f32 x = v[0] * (mat[d] + i * d_mat[d]); \
+			for (u32 s = 1; s < nsrc; s++) \
+				x += v[s] * (mat[s*ndst + d] + i * d_mat[s*ndst + d]); \
+			ACC_ ## bus(dst[ndst*i + d], x); \
+		} \
+	} \
+} \
+static void resample_scalar_ ## bus ## _ ## T ## _generic(void *dst, const void *src, u32 frames, f64 pos, f64 step, f64 d_step, const f32 *mat, const f32 *d_mat, u32 src_channels, u32 dst_channels) { \
+	resample_frames_ ## bus ## _ ## T(dst, src, frames, pos, step, d_step, mat, d_mat, src_channels, dst_channels); \
+}
+FORMATS(SCALAR_RESAMPLE_FRAMES, s32, _)
+FORMATS(SCALAR_RESAMPLE_FRAMES, f32, _)
+#undef SCALAR_RESAMPLE_FRAMES
+
+#define SCALAR_RESAMPLE_KERNEL(bus, T, nsrc, ndst) \
+static void resample_scalar_ ## bus ## _ ## T ## _ ## nsrc ## _ ## ndst(void *dst, const void *src, u32 frames, f64 pos, f64 step, f64 d_step, const f32 *mat, const f32 *d_mat, u32 src_channels, u32 dst_channels) { \
+	resample_frames_ ## bus ## _ ## T(dst, src, frames, pos, step, d_step, mat, d_mat, nsrc, ndst); \
+}
+GAX_MIX_LAYOUTS(LAYOUT_KERNELS, SCALAR_RESAMPLE_KERNEL)
+#undef SCALAR_RESAMPLE_KERNEL
+
+// dst[i] += src[i], for summing partial mixes
+static void add_scalar_s32(void *vdst, const void *vsrc, usz n) {
+	s32 *dst = vdst;
+	const s32 *src = vsrc;
+	for (usz i = 0; i < n; i++) dst[i] += src[i];
+}
+static void add_scalar_f32(void *vdst, const void *vsrc, usz n) {
+	f32 *dst = vdst;
+	const f32 *src = vsrc;
+	for (usz i = 0; i < n; i++) dst[i] += src[i];
+}
+
+// Output conversion (see GaXCbMixConvert).  Without dither, samples are
+// truncated, as the ga_trans_* functions do; with it, rounded to nearest.
+// The S32 bus is already at s16 resolution, so only its U8 output dithers
+#define DITHER(noise, lag, i) ((noise)[(i) + (lag)] - (noise)[i])
+static void convert_scalar_s32_u8(void *vdst, const void *vmix, usz n, const f32 *noise, usz lag) {
+	u8 *dst = vdst;
+	const s32 *mix = vmix;
+	for (usz i = 0; i < n; i++) {
+		s32 s = clamp(mix[i], -32768, 32767);
+		if (noise) {
+			long r = lrintf(s * (1.f / 256) + DITHER(noise, lag, i)) + 128;
+			dst[i] = clamp(r, 0, 255);
+		} else {
+			dst[i] = ga_trans_u8_of_s16(s);
+		}
+	}
+}
+static void convert_scalar_s32_s16(void *vdst, const void *vmix, usz n, const f32 *noise, usz lag) {
+	s16 *dst = vdst;
+	const s32 *mix = vmix;
+	for (usz i = 0; i < n; i++) dst[i] = clamp(mix[i], -32768, 32767);
+}
+static void convert_scalar_s32_s32(void *vdst, const void *vmix, usz n, const f32 *noise, usz lag) {
+	s32 *dst = vdst;
+	const s32 *mix = vmix;
+	for (usz i = 0; i < n; i++) dst[i] = ga_trans_s32_of_s16(clamp(mix[i], -32768, 32767));
+}
+static void convert_scalar_s32_f32(void *vdst, const void *vmix, usz n, const f32 *noise, usz lag) {
+	f32 *dst = vdst;
+	const s32 *mix = vmix;
+	for (usz i = 0; i < n; i++) dst[i] = ga_trans_f32_of_s16(clamp(mix[i], -32768, 32767));
+}
+static void convert_scalar_f32_u8(void *vdst, const void *vmix, usz n, const f32 *noise, usz lag) {
+	u8 *dst = vdst;
+	const f32 *mix = vmix;
+	for (usz i = 0; i < n; i++) {
+		f32 f = clamp(mix[i], -1, 1);
+		if (noise) {
+			long r = lrintf(f * (127.f + (f < 0)) + DITHER(noise, lag, i)) + 128;
+			dst[i] = clamp(r, 0, 255);
+		} else {
+			dst[i] = ga_trans_u8_of_f32(f);
+		}
+	}
+}
+static void convert_scalar_f32_s16(void *vdst, const void *vmix, usz n, const f32 *noise, usz lag) {
+	s16 *dst = vdst;
+	const f32 *mix = vmix;
+	for (usz i = 0; i < n; i++) {
+		f32 f = clamp(mix[i], -1, 1);
+		if (noise) {
+			long r = lrintf(f * (32767.f + (f < 0)) + DITHER(noise, lag, i));
+			dst[i] = clamp(r, -32768, 32767);
+		} else {
+			dst[i] = ga_trans_s16_of_f32(f);
+		}
+	}
+}
+static void convert_scalar_f32_s32(void *vdst, const void *vmix, usz n, const f32 *noise, usz lag) {
+	s32 *dst = vdst;
+	const f32 *mix = vmix;
+	// 2³¹ itself doesn't fit, so clamp after scaling
+	for (usz i = 0; i < n; i++) dst[i] = clamp(mix[i] * 2147483648., GA_S32_MIN, GA_S32_MAX);
+}
+static void convert_scalar_f32_f32(void *vdst, const void *vmix, usz n, const f32 *noise, usz lag) {
+	// leave any excursions beyond ±1 for the device to deal with
+	memcpy(vdst, vmix, n * sizeof(f32));
+}
+
+// Limiter (see gaX_mixer_limit).  The vector versions specialize on mono
+// and stereo, and leave other layouts to these
+static void peaks_scalar_s32(f32 *peaks, const void *vmix, u32 frames, u32 channels) {
+	const s32 *mix = vmix;
+	for (u32 i = 0; i < frames; i++) {
+		f32 p = 0;
+		for (u32 c = 0; c < channels; c++) {
+			f32 x = fabsf((f32)mix[i * channels + c]);
+			p = max(p, x);
+		}
+		peaks[i] = p * (1.f / 32768);
+	}
+}
+static void peaks_scalar_f32(f32 *peaks, const void *vmix, u32 frames, u32 channels) {
+	const f32 *mix = vmix;
+	for (u32 i = 0; i < frames; i++) {
+		f32 p = 0;
+		for (u32 c = 0; c < channels; c++) {
+			f32 x = fabsf(mix[i * channels + c]);
+			p = max(p, x);
+		}
+		peaks[i] = p;
+	}
+}
+static void gain_scalar_s32(void *vmix, const f32 *gains, u32 frames, u32 channels) {
+	s32 *mix = vmix;
+	for (u32 i = 0; i < frames; i++) {
+		for (u32 c = 0; c < channels; c++) mix[i * channels + c] = (s32)(mix[i * channels + c] * gains[i]);
+	}
+}
+static void gain_scalar_f32(void *vmix, const f32 *gains, u32 frames, u32 channels) {
+	f32 *mix = vmix;
+	for (u32 i = 0; i < frames; i++) {
+		for (u32 c = 0; c < channels; c++) mix[i * channels + c] *= gains[i];
+	}
+}
+
+// one step of xorshift32, and the top 23 bits of the result as a float in [-0.5, 0.5)
+static inline u32 xorshift32(u32 x) {
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return x;
+}
+static inline f32 noise_of_u32(u32 x) {
+	union { u32 u; f32 f; } v = {.u = x >> 9 | 0x3f800000};
+	return v.f - 1.5f;
+}
+static void noise_scalar(f32 *noise, usz n, u32 *state) {
+	for (usz i = 0; i < n; i++) {
+		u32 *x = &state[i % GAX_NOISE_LANES];
+		noise[i] = noise_of_u32(*x = xorshift32(*x));
+	}
+}
+
+static f32 dot_scalar(const f32 *a, const f32 *b, u32 n) {
+	f32 s[4] = {0};
+	for (u32 i = 0; i < n; i += 4) {
+		for (u32 k = 0; k < 4; k++) s[k] += a[i + k] * b[i + k];
+	}
+	return (s[0] + s[2]) + (s[1] + s[3]);
+}
+
+static void lerp_scalar_1(f32 *dst, const f32 *src, const u32 *idx, const f32 *frac, u32 n, f32 rate) {
+	for (u32 i = 0; i < n; i++) {
+		f32 s = src[idx[i]];
+		dst[i] = s + (src[idx[i] + 1] - s) * frac[i] / rate;
+	}
+}
+static void lerp_scalar_2(f32 *dst, const f32 *src, const u32 *idx, const f32 *frac, u32 n, f32 rate) {
+	for (u32 i = 0; i < n; i++) {
+		for (u32 c = 0; c < 2; c++) {
+			f32 s = src[2 * idx[i] + c];
+			dst[2 * i + c] = s + (src[2 * idx[i] + 2 + c] - s) * frac[i] / rate;
+		}
+	}
+}
+
+// the vectorized layouts come from isa, the rest from the scalar kernels
+#define LAYOUT_ENTRY(nsrc, ndst, isa, bus, T) [GaXMixLayout_ ## nsrc ## _ ## ndst] = mix_ ## isa ## _ ## bus ## _ ## T ## _ ## nsrc ## _ ## ndst,
+#define FORMAT_TABLE(isa, bus, T) { \
+	GAX_MIX_LAYOUTS_SIMD(LAYOUT_ENTRY, isa, bus, T) \
+	GAX_MIX_LAYOUTS_SCALAR(LAYOUT_ENTRY, scalar, bus, T) \
+	[GaXMixLayout_Generic] = mix_scalar_ ## bus ## _ ## T ## _generic, \
+}
+#define BUS_TABLE(isa, bus) { \
+	FORMAT_TABLE(isa, bus, u8), \
+	FORMAT_TABLE(isa, bus, s16), \
+	FORMAT_TABLE(isa, bus, s32), \
+	FORMAT_TABLE(isa, bus, f32), \
+}
+#define RESAMPLE_ENTRY(nsrc, ndst, bus, T) [GaXMixLayout_ ## nsrc ## _ ## ndst] = resample_scalar_ ## bus ## _ ## T ## _ ## nsrc ## _ ## ndst,
+#define RESAMPLE_FORMAT_TABLE(bus, T) { \
+	GAX_MIX_LAYOUTS(RESAMPLE_ENTRY, bus, T) \
+	[GaXMixLayout_Generic] = resample_scalar_ ## bus ## _ ## T ## _generic, \
+}
+#define RESAMPLE_BUS_TABLE(bus) { \
+	RESAMPLE_FORMAT_TABLE(bus, u8), \
+	RESAMPLE_FORMAT_TABLE(bus, s16), \
+	RESAMPLE_FORMAT_TABLE(bus, s32), \
+	RESAMPLE_FORMAT_TABLE(bus, f32), \
+}
+#define CONVERT_TABLE(isa, bus) { \
+	convert_ ## isa ## _ ## bus ## _u8, convert_ ## isa ## _ ## bus ## _s16, \
+	convert_ ## isa ## _ ## bus ## _s32, convert_ ## isa ## _ ## bus ## _f32, \
+}
+// the converters (and limiter and filter kernels) may come from another isa than the mix kernels
+#define KERNEL_TABLE(isa) KERNEL_TABLE_CONVERT(isa, isa)
+#define KERNEL_TABLE_CONVERT(isa, convert_isa) { \
+	.name = #isa, \
+	.mix = { BUS_TABLE(isa, s32), BUS_TABLE(isa, f32) }, \
+	.resample = { RESAMPLE_BUS_TABLE(s32), RESAMPLE_BUS_TABLE(f32) }, \
+	.add = { add_ ## isa ## _s32, add_ ## isa ## _f32 }, \
+	.convert = { CONVERT_TABLE(convert_isa, s32), CONVERT_TABLE(convert_isa, f32) }, \
+	.noise = noise_ ## isa, \
+	.peaks = { peaks_ ## convert_isa ## _s32, peaks_ ## convert_isa ## _f32 }, \
+	.gain = { gain_ ## convert_isa ## _s32, gain_ ## convert_isa ## _f32 }, \
+	.dot = dot_ ## convert_isa, \
+	.lerp = { lerp_ ## convert_isa ## _1, lerp_ ## convert_isa ## _2 }, \
+}
+
+const GaXMixKernels gaX_mix_kernels_scalar = KERNEL_TABLE(scalar);
+
+#ifdef GAX_X86
+/* SSE2: 4 frames at a time */
+GAX_TARGET("sse2") static inline __m128 sse2_load_u8(const u8 *s) {
+	u32 w;
+	memcpy(&w, s, 4);
+	__m128i z = _mm_setzero_si128();
+	__m128i x = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(w), z), z);
+	return _mm_cvtepi32_ps(_mm_sub_epi32(x, _mm_set1_epi32(128)));
+}
+GAX_TARGET("sse2") static inline __m128 sse2_load_s16(const s16 *s) {
+	__m128i x = _mm_loadl_epi64((const __m128i*)s);
+	return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16));
+}
+GAX_TARGET("sse2") static inline __m128 sse2_load_s32(const s32 *s) {
+	return _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)s));
+}
+GAX_TARGET("sse2") static inline __m128 sse2_load_f32(const f32 *s) {
+	return _mm_loadu_ps(s);
+}
+
+// s0/s1 get interleaved stereo samples for frames 0-1 and 2-3
+#define SSE2_LOAD_1(T, s, s0, s1) do { __m128 m = sse2_load_ ## T(s); s0 = _mm_unpacklo_ps(m, m); s1 = _mm_unpackhi_ps(m, m); } while (0)
+#define SSE2_LOAD_2(T, s, s0, s1) do { s0 = sse2_load_ ## T(s); s1 = sse2_load_ ## T((s) + 4); } while (0)
+// (l, r, l, r) -> (r, l, r, l)
+#define SSE2_SWAP(x) _mm_shuffle_ps(x, x, _MM_SHUFFLE(2, 3, 0, 1))
+// matrix entries m ramped to the frames in idx
+#define SSE2_RAMP(m, dm, idx) _mm_add_ps(m, _mm_mul_ps(idx, dm))
+
+#define SSE2_ACC_s32(d, x) _mm_storeu_si128((__m128i*)(d), _mm_add_epi32(_mm_loadu_si128((__m128i*)(d)), _mm_cvttps_epi32(x)))
+#define SSE2_ACC_f32(d, x) _mm_storeu_ps(d, _mm_add_ps(_mm_loadu_ps(d), x))
+
+// mono mixers: one frame per lane
+#define SSE2_KERNEL_1_1(bus, T, ...) \
+GAX_TARGET("sse2") static void mix_sse2_ ## bus ## _ ## T ## _1_1(void *vdst, const void *vsrc, u32 frames, const f32 *mat, const f32 *d_mat, u32 src_channels, u32 dst_channels) { \
+	bus *dst = vdst; \
+	const T *src = vsrc; \
+	const __m128 scale = _mm_set1_ps(SCALE(bus, T)), m = _mm_set1_ps(mat[0]), dm = _mm_set1_ps(d_mat[0]); \
+	u32 i = 0; \
+	for (; i + 4 <= frames; i += 4) { \
+		__m128 idx = _mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32(i), _mm_setr_epi32(0, 1, 2, 3))); \
+		SSE2_ACC_ ## bus(dst + i, _mm_mul_ps(_mm_mul_ps(sse2_load_ ## T(src + i), scale), SSE2_RAMP(m, dm, idx))); \
+	} \
+	mix_frames_ ## bus ## _ ## T(dst, src, i, frames, mat, d_mat, 1, 1); \
+}
+// stereo sources are split into left and right halves and downmixed
+#define SSE2_KERNEL_2_1(bus, T, ...) \
+GAX_TARGET("sse2") static void mix_sse2_ ## bus ## _ ## T ## _2_1(void *vdst, const void *vsrc, u32 frames, const f32 *mat, const f32 *d_mat, u32 src_channels, u32 dst_channels) { \
+	bus *dst = vdst; \
+	const T *src = vsrc; \
+	const __m128 scale = _mm_set1_ps(SCALE(bus, T)); \
+	const __m128 ml = _mm_set1_ps(mat[0]), dml = _mm_set1_ps(d_mat[0]), mr = _mm_set1_ps(mat[1]), dmr = _mm_set1_ps(d_mat[1]); \
+	u32 i = 0; \
+	for (; i + 4 <= frames; i += 4) { \
+		__m128 idx = _mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32(i), _mm_setr_epi32(0, 1, 2, 3))); \
+		__m128 s0, s1; \
+		SSE2_LOAD_2(T, src + 2*i, s0, s1); \
+		__m128 l = _mm_shuffle_ps(s0, s1, _MM_SHUFFLE(2, 0, 2, 0)); \
+		__m128 r = _mm_shuffle_ps(s0, s1, _MM_SHUFFLE(3, 1, 3, 1)); \
+		SSE2_ACC_ ## bus(dst + i, _mm_add_ps(_mm_mul_ps(_mm_mul_ps(l, scale), SSE2_RAMP(ml, dml, idx)), \
+		                                     _mm_mul_ps(_mm_mul_ps(r, scale), SSE2_RAMP(mr, dmr, idx)))); \
+	} \
+	mix_frames_ ## bus ## _ ## T(dst, src, i, frames, mat, d_mat, 2, 1); \
+}
+// lanes hold (left, right, left, right) of two frames; i0/i1 are their frame numbers
+#define SSE2_KERNEL_1_2(bus, T, ...) \
+GAX_TARGET("sse2") static void mix_sse2_ ## bus ## _ ## T ## _1_2(void *vdst, const void *vsrc, u32 frames, const f32 *mat, const f32 *d_mat, u32 src_channels, u32 dst_channels) { \
+	bus *dst = vdst; \
+	const T *src = vsrc; \
+	const __m128 scale = _mm_set1_ps(SCALE(bus, T)), two = _mm_set1_ps(2); \
+	const __m128 m = _mm_setr_ps(mat[0], mat[1], mat[0], mat[1]), dm = _mm_setr_ps(d_mat[0], d_mat[1], d_mat[0], d_mat[1]); \
+	u32 i = 0; \
+	for (; i + 4 <= frames; i += 4) { \
+		__m128 i0 = _mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32(i), _mm_setr_epi32(0, 0, 1, 1))), i1 = _mm_add_ps(i0, two); \
+		__m128 s0, s1; \
+		SSE2_LOAD_1(T, src + i, s0, s1); \
+		SSE2_ACC_ ## bus(dst + 2*i,     _mm_mul_ps(_mm_mul_ps(s0, scale), SSE2_RAMP(m, dm, i0))); \
+		SSE2_ACC_ ## bus(dst + 2*i + 4, _mm_mul_ps(_mm_mul_ps(s1, scale), SSE2_RAMP(m, dm, i1))); \
+	} \
+	mix_frames_ ## bus ## _ ## T(dst, src, i, frames, mat, d_mat, 1, 2); \
+}
+// m takes each channel to its own side, x across to the other.  Lanes add
+// the two in a different order from the scalar kernel, which with only two
+// terms makes no difference
+#define SSE2_KERNEL_2_2(bus, T, ...) \
+GAX_TARGET("sse2") static void mix_sse2_ ## bus ## _ ## T ## _2_2(void *vdst, const void *vsrc, u32 frames, const f32 *mat, const f32 *d_mat, u32 src_channels, u32 dst_channels) { \
+	bus *dst = vdst; \
+	const T *src = vsrc; \
+	const __m128 scale = _mm_set1_ps(SCALE(bus, T)), two = _mm_set1_ps(2); \
+	const __m128 m = _mm_setr_ps(mat[0], mat[3], mat[0], mat[3]), dm = _mm_setr_ps(d_mat[0], d_mat[3], d_mat[0], d_mat[3]); \
+	const __m128 x = _mm_setr_ps(mat[2], mat[1], mat[2], mat[1]), dx = _mm_setr_ps(d_mat[2], d_mat[1], d_mat[2], d_mat[1]); \
+	u32 i = 0; \
+	for (; i + 4 <= frames; i += 4) { \
+		__m128 i0 = _mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32(i), _mm_setr_epi32(0, 0, 1, 1))), i1 = _mm_add_ps(i0, two); \
+		__m128 s0, s1; \
+		SSE2_LOAD_2(T, src + 2*i, s0, s1); \
+		s0 = _mm_mul_ps(s0, scale); \
+		s1 = _mm_mul_ps(s1, scale); \
+		SSE2_ACC_ ## bus(dst + 2*i,     _mm_add_ps(_mm_mul_ps(s0, SSE2_RAMP(m, dm, i0)), _mm_mul_ps(SSE2_SWAP(s0), SSE2_RAMP(x, dx, i0)))); \
+		SSE2_ACC_ ## bus(dst + 2*i + 4, _mm_add_ps(_mm_mul_ps(s1, SSE2_RAMP(m, dm, i1)), _mm_mul_ps(SSE2_SWAP(s1), SSE2_RAMP(x, dx, i1)))); \
+	} \
+	mix_frames_ ## bus ## _ ## T(dst, src, i, frames, mat, d_mat, 2, 2); \
+}
+LAYOUT_KERNELS(1, 1, SSE2_KERNEL_1_1)
+LAYOUT_KERNELS(2, 1, SSE2_KERNEL_2_1)
+LAYOUT_KERNELS(1, 2, SSE2_KERNEL_1_2)
+LAYOUT_KERNELS(2, 2, SSE2_KERNEL_2_2)
+#undef SSE2_KERNEL_1_1
+#undef SSE2_KERNEL_2_1
+#undef SSE2_KERNEL_1_2
+#undef SSE2_KERNEL_2_2
+#undef SSE2_ACC_s32
+#undef SSE2_ACC_f32
+#undef SSE2_RAMP
+#undef SSE2_SWAP
+#undef SSE2_LOAD_1
+#undef SSE2_LOAD_2
+
+GAX_TARGET("sse2") static void add_sse2_s32(void *vdst, const void *vsrc, usz n) {
+	s32 *dst = vdst;
+	const s32 *src = vsrc;
+	usz i = 0;
+	for (; i + 4 <= n; i += 4) {
+		__m128i *d = (__m128i*)(dst + i);
+		_mm_storeu_si128(d, _mm_add_epi32(_mm_loadu_si128(d), _mm_loadu_si128((const __m128i*)(src + i))));
+	}
+	add_scalar_s32(dst + i, src + i, n - i);
+}
+GAX_TARGET("sse2") static void add_sse2_f32(void *vdst, const void *vsrc, usz n) {
+	f32 *dst = vdst;
+	const f32 *src = vsrc;
+	usz i = 0;
+	for (; i + 4 <= n; i += 4) _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_loadu_ps(src + i)));
+	add_scalar_f32(dst + i, src + i, n - i);
+}
+
+// Output conversion, 8 samples at a time.  The s32 bus saturates to s16
+// with packs, like the scalar clamp
+GAX_TARGET("sse2") static inline __m128 sse2_dither(const f32 *noise, usz lag, usz i) {
+	return _mm_sub_ps(_mm_loadu_ps(noise + i + lag), _mm_loadu_ps(noise + i));
+}
+#define SSE2_LOAD_S16(mix, i) _mm_packs_epi32(_mm_loadu_si128((const __m128i*)((mix) + (i))), _mm_loadu_si128((const __m128i*)((mix) + (i) + 4)))
+// s16 lanes back to s32
+#define SSE2_WIDEN_LO(x) _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16)
+#define SSE2_WIDEN_HI(x) _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16)
+// s32 lanes to u8, saturating, into the low 8 bytes
+#define SSE2_PACK_U8(a, b) _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_setzero_si128())
+// mix clamped to [-1, 1], and the scale taking it to n-bit output
+#define SSE2_LOAD_F32(mix, i) _mm_min_ps(_mm_max_ps(_mm_loadu_ps((mix) + (i)), _mm_set1_ps(-1)), _mm_set1_ps(1))
+#define SSE2_SCALE(f, pos) _mm_add_ps(_mm_set1_ps(pos), _mm_and_ps(_mm_cmplt_ps(f, _mm_setzero_ps()), _mm_set1_ps(1)))
+
+GAX_TARGET("sse2") static void convert_sse2_s32_u8(void *vdst, const void *vmix, usz n, const f32 *noise, usz lag) {
+	u8 *dst = vdst;
+	const s32 *mix = vmix;
+	const __m128i c128 = _mm_set1_epi32(128);
+	const __m128 scale = _mm_set1_ps(1.f / 256);
+	usz i = 0;
+	if (noise) {
+		for (; i + 8 <= n; i += 8) {
+			__m128i s = SSE2_LOAD_S16(mix, i);
+			__m128i a = _mm_cvtps_epi32(_mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(SSE2_WIDEN_LO(s)), scale), sse2_dither(noise, lag, i)));
+			__m128i b = _mm_cvtps_epi32(_mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(SSE2_WIDEN_HI(s)), scale), sse2_dither(noise, lag, i + 4)));
+			_mm_storel_epi64((__m128i*)(dst + i), SSE2_PACK_U8(_mm_add_epi32(a, c128), _mm_add_epi32(b, c128)));
+		}
+	} else {
+		for (; i + 8 <= n; i += 8) {
+			__m128i u = _mm_srli_epi16(_mm_xor_si128(SSE2_LOAD_S16(mix, i), _mm_set1_epi16(-32768)), 8);
+			_mm_storel_epi64((__m128i*)(dst + i), _mm_packus_epi16(u, _mm_setzero_si128()));
+		}
+	}
+	convert_scalar_s32_u8(dst + i, mix + i, n - i, noise ? noise + i : NULL, lag);
+}
+GAX_TARGET("sse2") static void convert_sse2_s32_s16(void *vdst, const void *vmix, usz n, const f32 *noise, usz lag) {
+	s16 *dst = vdst;
+	const s32 *mix = vmix;
+	usz i = 0;
+	for (; i + 8 <= n; i += 8) _mm_storeu_si128((__m128i*)(dst + i), SSE2_LOAD_S16(mix, i));
+	convert_scalar_s32_s16(dst + i, mix + i, n - i, NULL, lag);
+}
+GAX_TARGET("sse2") static void convert_sse2_s32_s32(void *vdst, const void *vmix, usz n, const f32 *noise, usz lag) {
+	s32 *dst = vdst;
+	const s32 *mix = vmix;
+	usz i = 0;
+	for (; i + 8 <= n; i += 8) {
+		__m128i s = SSE2_LOAD_S16(mix, i);
+		_mm_storeu_si128((__m128i*)(dst + i),     _mm_unpacklo_epi16(_mm_setzero_si128(), s));
+		_mm_storeu_si128((__m128i*)(dst + i + 4), _mm_unpackhi_epi16(_mm_setzero_si128(), s));
+	}
+	convert_scalar_s32_s32(dst + i, mix + i, n - i, NULL, lag);
+}
+GAX_TARGET("sse2") static void convert_sse2_s32_f32(void *vdst, const void *vmix, usz n, const f32 *noise, usz lag) {
+	f32 *dst = vdst;
+	const s32 *mix = vmix;
+	usz i = 0;
+	for (; i + 8 <= n; i += 8) {
+		__m128i s = SSE2_LOAD_S16(mix, i);
+		__m128 a = _mm_cvtepi32_ps(SSE2_WIDEN_LO(s)), b = _mm_cvtepi32_ps(SSE2_WIDEN_HI(s));
+		_mm_storeu_ps(dst + i,     _mm_div_ps(a, SSE2_SCALE(a, 32767)));
+		_mm_storeu_ps(dst + i + 4, _mm_div_ps(b, SSE2_SCALE(b, 32767)));
+	}
+	convert_scalar_s32_f32(dst + i, mix + i, n - i, NULL, lag);
+}
+GAX_TARGET("sse2") static void convert_sse2_f32_u8(void *vdst, const void *vmix, usz n, const f32 *noise, usz lag) {
+	u8 *dst = vdst;
+	const f32 *mix = vmix;
+	const __m128i c128 = _mm_set1_epi32(128);
+	usz i = 0;
+	if (noise) {
+		for (; i + 8 <= n; i += 8) {
+			__m128 f = SSE2_LOAD_F32(mix, i), g = SSE2_LOAD_F32(mix, i + 4);
+			__m128i a = _mm_cvtps_epi32(_mm_add_ps(_mm_mul_ps(f, SSE2_SCALE(f, 127)), sse2_dither(noise, lag, i)));
+			__m128i b = _mm_cvtps_epi32(_mm_add_ps(_mm_mul_ps(g, SSE2_SCALE(g, 127)), sse2_dither(noise, lag, i + 4)));
+			_mm_storel_epi64((__m128i*)(dst + i), SSE2_PACK_U8(_mm_add_epi32(a, c128), _mm_add_epi32(b, c128)));
+		}
+	} else {
+		for (; i + 8 <= n; i += 8) {
+			__m128 f = SSE2_LOAD_F32(mix, i), g = SSE2_LOAD_F32(mix, i + 4);
+			__m128i a = _mm_cvttps_epi32(_mm_add_ps(_mm_set1_ps(128), _mm_mul_ps(f, SSE2_SCALE(f, 127))));
+			__m128i b = _mm_cvttps_epi32(_mm_add_ps(_mm_set1_ps(128), _mm_mul_ps(g, SSE2_SCALE(g, 127))));
+			_mm_storel_epi64((__m128i*)(dst + i), SSE2_PACK_U8(a, b));
+		}
+	}
+	convert_scalar_f32_u8(dst + i, mix + i, n - i, noise ? noise + i : NULL, lag);
+}
+GAX_TARGET("sse2") static void convert_sse2_f32_s16(void *vdst, const void *vmix, usz n, const f32 *noise, usz lag) {
+	s16 *dst = vdst;
+	const f32 *mix = vmix;
+	usz i = 0;
+	if (noise) {
+		for (; i + 8 <= n; i += 8) {
+			__m128 f = SSE2_LOAD_F32(mix, i), g = SSE2_LOAD_F32(mix, i + 4);
+			__m128i a = _mm_cvtps_epi32(_mm_add_ps(_mm_mul_ps(f, SSE2_SCALE(f, 32767)), sse2_dither(noise, lag, i)));
+			__m128i b = _mm_cvtps_epi32(_mm_add_ps(_mm_mul_ps(g, SSE2_SCALE(g, 32767)), sse2_dither(noise, lag, i + 4)));
+			_mm_storeu_si128((__m128i*)(dst + i), _mm_packs_epi32(a, b));
+		}
+	} else {
+		for (; i + 8 <= n; i += 8) {
+			__m128 f = SSE2_LOAD_F32(mix, i), g = SSE2_LOAD_F32(mix, i + 4);
+			__m128i a = _mm_cvttps_epi32(_mm_mul_ps(f, SSE2_SCALE(f, 32767)));
+			__m128i b = _mm_cvttps_epi32(_mm_mul_ps(g, SSE2_SCALE(g, 32767)));
+			_mm_storeu_si128((__m128i*)(dst + i), _mm_packs_epi32(a, b));
+		}
+	}
+	convert_scalar_f32_s16(dst + i, mix + i, n - i, noise ? noise + i : NULL, lag);
+}
+GAX_TARGET("sse2") static void convert_sse2_f32_s32(void *vdst, const void *vmix, usz n, const f32 *noise, usz lag) {
+	s32 *dst = vdst;
+	const f32 *mix = vmix;
+	const __m128 c2p31 = _mm_set1_ps(2147483648.f);
+	usz i = 0;
+	for (; i + 4 <= n; i += 4) {
+		// cvtt gives INT_MIN for anything out of range; flip it to INT_MAX at the top
+		__m128 y = _mm_mul_ps(_mm_loadu_ps(mix + i), c2p31);
+		__m128i r = _mm_xor_si128(_mm_cvttps_epi32(y), _mm_castps_si128(_mm_cmpge_ps(y, c2p31)));
+		_mm_storeu_si128((__m128i*)(dst + i), r);
+	}
+	convert_scalar_f32_s32(dst + i, mix + i, n - i, NULL, lag);
+}
+GAX_TARGET("sse2") static void convert_sse2_f32_f32(void *vdst, const void *vmix, usz n, const f32 *noise, usz lag) {
+	convert_scalar_f32_f32(vdst, vmix, n, NULL, lag);
+}
+#undef SSE2_LOAD_S16
+#undef SSE2_WIDEN_LO
+#undef SSE2_WIDEN_HI
+#undef SSE2_PACK_U8
+#undef SSE2_LOAD_F32
+#undef SSE2_SCALE
+
+// 4 frames at a time
+#define SSE2_ABS(x) _mm_andnot_ps(_mm_set1_ps(-0.f), x)
+#define SSE2_LOAD_ABS_s32(mix, i) SSE2_ABS(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)((mix) + (i)))))
+#define SSE2_LOAD_ABS_f32(mix, i) SSE2_ABS(_mm_loadu_ps((mix) + (i)))
+#define SSE2_PEAKS(bus, scale) \
+GAX_TARGET("sse2") static void peaks_sse2_ ## bus(f32 *peaks, const void *vmix, u32 frames, u32 channels) { \
+	const bus *mix = vmix; \
+	const __m128 k = _mm_set1_ps(scale); \
+	u32 i = 0; \
+	if (channels == 1) { \
+		for (; i + 4 <= frames; i += 4) _mm_storeu_ps(peaks + i, _mm_mul_ps(SSE2_LOAD_ABS_ ## bus(mix, i), k)); \
+	} else if (channels == 2) { \
+		for (; i + 4 <= frames; i += 4) { \
+			__m128 a = SSE2_LOAD_ABS_ ## bus(mix, 2*i), b = SSE2_LOAD_ABS_ ## bus(mix, 2*i + 4); \
+			__m128 l = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)), r = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)); \
+			_mm_storeu_ps(peaks + i, _mm_mul_ps(_mm_max_ps(r, l), k)); \
+		} \
+	} \
+	peaks_scalar_ ## bus(peaks + i, mix + i * channels, frames - i, channels); \
+}
+SSE2_PEAKS(s32, 1.f / 32768)
+SSE2_PEAKS(f32, 1.f)
+#undef SSE2_PEAKS
+#undef SSE2_LOAD_ABS_s32
+#undef SSE2_LOAD_ABS_f32
+#undef SSE2_ABS
+
+#define SSE2_GAIN_s32(mix, i, g) _mm_storeu_si128((__m128i*)((mix) + (i)), _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)((mix) + (i)))), g)))
+#define SSE2_GAIN_f32(mix, i, g) _mm_storeu_ps((mix) + (i), _mm_mul_ps(_mm_loadu_ps((mix) + (i)), g))
+#define SSE2_GAIN(bus) \
+GAX_TARGET("sse2") static void gain_sse2_ ## bus(void *vmix, const f32 *gains, u32 frames, u32 channels) { \
+	bus *mix = vmix; \
+	u32 i = 0; \
+	if (channels == 1) { \
+		for (; i + 4 <= frames; i += 4) SSE2_GAIN_ ## bus(mix, i, _mm_loadu_ps(gains + i)); \
+	} else if (channels == 2) { \
+		for (; i + 4 <= frames; i += 4) { \
+			__m128 g = _mm_loadu_ps(gains + i); \
+			SSE2_GAIN_ ## bus(mix, 2*i,     _mm_unpacklo_ps(g, g)); \
+			SSE2_GAIN_ ## bus(mix, 2*i + 4, _mm_unpackhi_ps(g, g)); \
+		} \
+	} \
+	gain_scalar_ ## bus(mix + i * channels, gains + i, frames - i, channels); \
+}
+SSE2_GAIN(s32)
+SSE2_GAIN(f32)
+#undef SSE2_GAIN
+#undef SSE2_GAIN_s32
+#undef SSE2_GAIN_f32
+
+#define SSE2_XORSHIFT(x) do { \
+	x = _mm_xor_si128(x, _mm_slli_epi32(x, 13)); \
+	x = _mm_xor_si128(x, _mm_srli_epi32(x, 17)); \
+	x = _mm_xor_si128(x, _mm_slli_epi32(x, 5)); \
+} while (0)
+#define SSE2_NOISE(x) _mm_sub_ps(_mm_castsi128_ps(_mm_or_si128(_mm_srli_epi32(x, 9), _mm_set1_epi32(0x3f800000))), _mm_set1_ps(1.5f))
+GAX_TARGET("sse2") static void noise_sse2(f32 *noise, usz n, u32 *state) {
+	__m128i x0 = _mm_loadu_si128((const __m128i*)state), x1 = _mm_loadu_si128((const __m128i*)(state + 4));
+	usz i = 0;
+	for (; i + 8 <= n; i += 8) {
+		SSE2_XORSHIFT(x0);
+		SSE2_XORSHIFT(x1);
+		_mm_storeu_ps(noise + i,     SSE2_NOISE(x0));
+		_mm_storeu_ps(noise + i + 4, SSE2_NOISE(x1));
+	}
+	_mm_storeu_si128((__m128i*)state, x0);
+	_mm_storeu_si128((__m128i*)(state + 4), x1);
+	noise_scalar(noise + i, n - i, state);
+}
+#undef SSE2_XORSHIFT
+#undef SSE2_NOISE
+
+GAX_TARGET("sse2") static f32 dot_sse2(const f32 *a, const f32 *b, u32 n) {
+	__m128 s = _mm_setzero_ps();
+	for (u32 i = 0; i < n; i += 4) s = _mm_add_ps(s, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+	s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+	return _mm_cvtss_f32(_mm_add_ss(s, _mm_shuffle_ps(s, s, 1)));
+}
+
+// Each frame to interpolate from sits next to the one it goes towards, so
+// a frame's pair comes in one load: 8 bytes of a mono source, 16 of a
+// stereo one, shuffled apart into the starts and the ends
+GAX_TARGET("sse2") static void lerp_sse2_1(f32 *dst, const f32 *src, const u32 *idx, const f32 *frac, u32 n, f32 rate) {
+	__m128 r = _mm_set1_ps(rate);
+	u32 i = 0;
+	for (; i + 4 <= n; i += 4) {
+		__m128 lo = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*)(src + idx[i])), (const __m64*)(src + idx[i + 1]));
+		__m128 hi = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*)(src + idx[i + 2])), (const __m64*)(src + idx[i + 3]));
+		__m128 s = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+		__m128 e = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+		_mm_storeu_ps(dst + i, _mm_add_ps(s, _mm_div_ps(_mm_mul_ps(_mm_sub_ps(e, s), _mm_loadu_ps(frac + i)), r)));
+	}
+	lerp_scalar_1(dst + i, src, idx + i, frac + i, n - i, rate);
+}
+GAX_TARGET("sse2") static void lerp_sse2_2(f32 *dst, const f32 *src, const u32 *idx, const f32 *frac, u32 n, f32 rate) {
+	__m128 r = _mm_set1_ps(rate);
+	u32 i = 0;
+	for (; i + 2 <= n; i += 2) {
+		__m128 a = _mm_loadu_ps(src + 2 * idx[i]), b = _mm_loadu_ps(src + 2 * idx[i + 1]);
+		__m128 s = _mm_movelh_ps(a, b), e = _mm_movehl_ps(b, a);
+		__m128 f = _mm_setr_ps(frac[i], frac[i], frac[i + 1], frac[i + 1]);
+		_mm_storeu_ps(dst + 2 * i, _mm_add_ps(s, _mm_div_ps(_mm_mul_ps(_mm_sub_ps(e, s), f), r)));
+	}
+	lerp_scalar_2(dst + 2 * i, src, idx + i, frac + i, n - i, rate);
+}
+
+static const GaXMixKernels kernels_sse2 = KERNEL_TABLE(sse2);
+
+/* AVX2: 8 frames at a time */
+GAX_TARGET("avx2") static inline __m256 avx2_load_u8(const u8 *s) {
+	__m256i x = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)s));
+	return _mm256_cvtepi32_ps(_mm256_sub_epi32(x, _mm256_set1_epi32(128)));
+}
+GAX_TARGET("avx2") static inline __m256 avx2_load_s16(const s16 *s) {
+	return _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)s)));
+}
+GAX_TARGET("avx2") static inline __m256 avx2_load_s32(const s32 *s) {
+	return _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i*)s));
+}
+GAX_TARGET("avx2") static inline __m256 avx2_load_f32(const f32 *s) {
+	return _mm256_loadu_ps(s);
+}
+
+// unpack{lo,hi} work within 128-bit lanes; stitch the lanes back into frame order
+#define AVX2_ZIP(a, b, lo, hi) do { \
+	__m256 _l = _mm256_unpacklo_ps(a, b), _h = _mm256_unpackhi_ps(a, b); \
+	lo = _mm256_permute2f128_ps(_l, _h, 0x20); \
+	hi = _mm256_permute2f128_ps(_l, _h, 0x31); \
+} while (0)
+#define AVX2_LOAD_1(T, s, s0, s1) do { __m256 m = avx2_load_ ## T(s); AVX2_ZIP(m, m, s0, s1); } while (0)
+#define AVX2_LOAD_2(T, s, s0, s1) do { s0 = avx2_load_ ## T(s); s1 = avx2_load_ ## T((s) + 8); } while (0)
+
+#define AVX2_ACC_s32(d, x) _mm256_storeu_si256((__m256i*)(d), _mm256_add_epi32(_mm256_loadu_si256((__m256i*)(d)), _mm256_cvttps_epi32(x)))
+#define AVX2_ACC_f32(d, x) _mm256_storeu_ps(d, _mm256_add_ps(_mm256_loadu_ps(d), x))
+
+// (l, r, l, r, ...) -> (r, l, r, l, ...)
+#define AVX2_SWAP(x) _mm256_permute_ps(x, _MM_SHUFFLE(2, 3, 0, 1))
+#define AVX2_RAMP(m, dm, idx) _mm256_add_ps(m, _mm256_mul_ps(idx, dm))
+
+// as for sse2, with twice the lanes
+#define AVX2_KERNEL_1_1(bus, T, ...) \
+GAX_TARGET("avx2") static void mix_avx2_ ## bus ## _ ## T ## _1_1(void *vdst, const void *vsrc, u32 frames, const f32 *mat, const f32 *d_mat, u32 src_channels, u32 dst_channels) { \
+	bus *dst = vdst; \
+	const T *src = vsrc; \
+	const __m256 scale = _mm256_set1_ps(SCALE(bus, T)), m = _mm256_set1_ps(mat[0]), dm = _mm256_set1_ps(d_mat[0]); \
+	u32 i = 0; \
+	for (; i + 8 <= frames; i += 8) { \
+		__m256 idx = _mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_set1_epi32(i), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7))); \
+		AVX2_ACC_ ## bus(dst + i, _mm256_mul_ps(_mm256_mul_ps(avx2_load_ ## T(src + i), scale), AVX2_RAMP(m, dm, idx))); \
+	} \
+	mix_frames_ ## bus ## _ ## T(dst, src, i, frames, mat, d_mat, 1, 1); \
+}
+// shuffle_ps splits each 128-bit lane, leaving frames in the order 0 1 4 5 2 3 6 7
+#define AVX2_UNZIP(a, b, sel) _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(_mm256_shuffle_ps(a, b, sel)), _MM_SHUFFLE(3, 1, 2, 0)))
+#define AVX2_KERNEL_2_1(bus, T, ...) \
+GAX_TARGET("avx2") static void mix_avx2_ ## bus ## _ ## T ## _2_1(void *vdst, const void *vsrc, u32 frames, const f32 *mat, const f32 *d_mat, u32 src_channels, u32 dst_channels) { \
+	bus *dst = vdst; \
+	const T *src = vsrc; \
+	const __m256 scale = _mm256_set1_ps(SCALE(bus, T)); \
+	const __m256 ml = _mm256_set1_ps(mat[0]), dml = _mm256_set1_ps(d_mat[0]), mr = _mm256_set1_ps(mat[1]), dmr = _mm256_set1_ps(d_mat[1]); \
+	u32 i = 0; \
+	for (; i + 8 <= frames; i += 8) { \
+		__m256 idx = _mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_set1_epi32(i), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7))); \
+		__m256 s0, s1; \
+		AVX2_LOAD_2(T, src + 2*i, s0, s1); \
+		__m256 l = AVX2_UNZIP(s0, s1, _MM_SHUFFLE(2, 0, 2, 0)); \
+		__m256 r = AVX2_UNZIP(s0, s1, _MM_SHUFFLE(3, 1, 3, 1)); \
+		AVX2_ACC_ ## bus(dst + i, _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(l, scale), AVX2_RAMP(ml, dml, idx)), \
+		                                        _mm256_mul_ps(_mm256_mul_ps(r, scale), AVX2_RAMP(mr, dmr, idx)))); \
+	} \
+	mix_frames_ ## bus ## _ ## T(dst, src, i, frames, mat, d_mat, 2, 1); \
+}
+// lanes hold (left, right) of four frames
+#define AVX2_KERNEL_1_2(bus, T, ...) \
+GAX_TARGET("avx2") static void mix_avx2_ ## bus ## _ ## T ## _1_2(void *vdst, const void *vsrc, u32 frames, const f32 *mat, const f32 *d_mat, u32 src_channels, u32 dst_channels) { \
+	bus *dst = vdst; \
+	const T *src = vsrc; \
+	const __m256 scale = _mm256_set1_ps(SCALE(bus, T)), four = _mm256_set1_ps(4); \
+	const __m256 m = _mm256_setr_ps(mat[0], mat[1], mat[0], mat[1], mat[0], mat[1], mat[0], mat[1]); \
+	const __m256 dm = _mm256_setr_ps(d_mat[0], d_mat[1], d_mat[0], d_mat[1], d_mat[0], d_mat[1], d_mat[0], d_mat[1]); \
+	u32 i = 0; \
+	for (; i + 8 <= frames; i += 8) { \
+		__m256 i0 = _mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_set1_epi32(i), _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3))), i1 = _mm256_add_ps(i0, four); \
+		__m256 s0, s1; \
+		AVX2_LOAD_1(T, src + i, s0, s1); \
+		AVX2_ACC_ ## bus(dst + 2*i,     _mm256_mul_ps(_mm256_mul_ps(s0, scale), AVX2_RAMP(m, dm, i0))); \
+		AVX2_ACC_ ## bus(dst + 2*i + 8, _mm256_mul_ps(_mm256_mul_ps(s1, scale), AVX2_RAMP(m, dm, i1))); \
+	} \
+	mix_frames_ ## bus ## _ ## T(dst, src, i, frames, mat, d_mat, 1, 2); \
+}
+#define AVX2_KERNEL_2_2(bus, T, ...) \
+GAX_TARGET("avx2") static void mix_avx2_ ## bus ## _ ## T ## _2_2(void *vdst, const void *vsrc, u32 frames, const f32 *mat, const f32 *d_mat, u32 src_channels, u32 dst_channels) { \
+	bus *dst = vdst; \
+	const T *src = vsrc; \
+	const __m256 scale = _mm256_set1_ps(SCALE(bus, T)), four = _mm256_set1_ps(4); \
+	const __m256 m = _mm256_setr_ps(mat[0], mat[3], mat[0], mat[3], mat[0], mat[3], mat[0], mat[3]); \
+	const __m256 dm = _mm256_setr_ps(d_mat[0], d_mat[3], d_mat[0], d_mat[3], d_mat[0], d_mat[3], d_mat[0], d_mat[3]); \
+	const __m256 x = _mm256_setr_ps(mat[2], mat[1], mat[2], mat[1], mat[2], mat[1], mat[2], mat[1]); \
+	const __m256 dx = _mm256_setr_ps(d_mat[2], d_mat[1], d_mat[2], d_mat[1], d_mat[2], d_mat[1], d_mat[2], d_mat[1]); \
+	u32 i = 0; \
+	for (; i + 8 <= frames; i += 8) { \
+		__m256 i0 = _mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_set1_epi32(i), _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3))), i1 = _mm256_add_ps(i0, four); \
+		__m256 s0, s1; \
+		AVX2_LOAD_2(T, src + 2*i, s0, s1); \
+		s0 = _mm256_mul_ps(s0, scale); \
+		s1 = _mm256_mul_ps(s1, scale); \
+		AVX2_ACC_ ## bus(dst + 2*i,     _mm256_add_ps(_mm256_mul_ps(s0, AVX2_RAMP(m, dm, i0)), _mm256_mul_ps(AVX2_SWAP(s0), AVX2_RAMP(x, dx, i0)))); \
+		AVX2_ACC_ ## bus(dst + 2*i + 8, _mm256_add_ps(_mm256_mul_ps(s1, AVX2_RAMP(m, dm, i1)), _mm256_mul_ps(AVX2_SWAP(s1), AVX2_RAMP(x, dx, i1)))); \
+	} \
+	mix_frames_ ## bus ## _ ## T(dst, src, i, frames, mat, d_mat, 2, 2); \
+}
+LAYOUT_KERNELS(1, 1, AVX2_KERNEL_1_1)
+LAYOUT_KERNELS(2, 1, AVX2_KERNEL_2_1)
+LAYOUT_KERNELS(1, 2, AVX2_KERNEL_1_2)
+LAYOUT_KERNELS(2, 2, AVX2_KERNEL_2_2)
+#undef AVX2_KERNEL_1_1
+#undef AVX2_KERNEL_2_1
+#undef AVX2_UNZIP
+#undef AVX2_KERNEL_1_2
+#undef AVX2_KERNEL_2_2
+#undef AVX2_RAMP
+#undef AVX2_SWAP
+#undef AVX2_ACC_s32
+#undef AVX2_ACC_f32
+#undef AVX2_LOAD_1
+#undef AVX2_LOAD_2
+#undef AVX2_ZIP
+
+GAX_TARGET("avx2") static void add_avx2_s32(void *vdst, const void *vsrc, usz n) {
+	s32 *dst = vdst;
+	const s32 *src = vsrc;
+	usz i = 0;
+	for (; i + 8 <= n; i += 8) {
+		__m256i *d = (__m256i*)(dst + i);
+		_mm256_storeu_si256(d, _mm256_add_epi32(_mm256_loadu_si256(d), _mm256_loadu_si256((const __m256i*)(src + i))));
+	}
+	add_scalar_s32(dst + i, src + i, n - i);
+}
+GAX_TARGET("avx2") static void add_avx2_f32(void *vdst, const void *vsrc, usz n) {
+	f32 *dst = vdst;
+	const f32 *src = vsrc;
+	usz i = 0;
+	for (; i + 8 <= n; i += 8) _mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_loadu_ps(dst + i), _mm256_loadu_ps(src + i)));
+	add_scalar_f32(dst + i, src + i, n - i);
+}
+
+GAX_TARGET("avx2") static void noise_avx2(f32 *noise, usz n, u32 *state) {
+	__m256i x = _mm256_loadu_si256((const __m256i*)state);
+	usz i = 0;
+	for (; i + 8 <= n; i += 8) {
+		x = _mm256_xor_si256(x, _mm256_slli_epi32(x, 13));
+		x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 17));
+		x = _mm256_xor_si256(x, _mm256_slli_epi32(x, 5));
+		__m256i m = _mm256_or_si256(_mm256_srli_epi32(x, 9), _mm256_set1_epi32(0x3f800000));
+		_mm256_storeu_ps(noise + i, _mm256_sub_ps(_mm256_castsi256_ps(m), _mm256_set1_ps(1.5f)));
+	}
+	_mm256_storeu_si256((__m256i*)state, x);
+	noise_scalar(noise + i, n - i, state);
+}
+
+// conversion is bound by memory, and 256-bit packs work within 128-bit
+// lanes anyway, so avx2 converts with sse2
+static const GaXMixKernels kernels_avx2 = KERNEL_TABLE_CONVERT(avx2, sse2);
+#endif //GAX_X86
+
+#ifdef GAX_NEON
+/* NEON: 4 frames at a time */
+static inline float32x4_t neon_load_u8(const u8 *s) {
+	u32 w;
+	memcpy(&w, s, 4);
+	uint16x4_t x = vget_low_u16(vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(w))));
+	return vcvtq_f32_s32(vsubq_s32(vreinterpretq_s32_u32(vmovl_u16(x)), vdupq_n_s32(128)));
+}
+static inline float32x4_t neon_load_s16(const s16 *s) {
+	return vcvtq_f32_s32(vmovl_s16(vld1_s16(s)));
+}
+static inline float32x4_t neon_load_s32(const s32 *s) {
+	return vcvtq_f32_s32(vld1q_s32(s));
+}
+static inline float32x4_t neon_load_f32(const f32 *s) {
+	return vld1q_f32(s);
+}
+
+#define NEON_LOAD_1(T, s, s0, s1) do { float32x4x2_t z = vzipq_f32(neon_load_ ## T(s), neon_load_ ## T(s)); s0 = z.val[0]; s1 = z.val[1]; } while (0)
+#define NEON_LOAD_2(T, s, s0, s1) do { s0 = neon_load_ ## T(s); s1 = neon_load_ ## T((s) + 4); } while (0)
+
+#define NEON_ACC_s32(d, x) vst1q_s32(d, vaddq_s32(vld1q_s32(d), vcvtq_s32_f32(x)))
+#define NEON_ACC_f32(d, x) vst1q_f32(d, vaddq_f32(vld1q_f32(d), x))
+
+// frame number of each lane, for mono and stereo lanes
+static const s32 neon_step[4] = {0, 1, 2, 3};
+static const s32 neon_step_lr[4] = {0, 0, 1, 1};
+
+#define NEON_SWAP(x) vrev64q_f32(x)
+#define NEON_RAMP(m, dm, idx) vaddq_f32(m, vmulq_f32(idx, dm))
+// lanes (a, b, a, b)
+#define NEON_PAIR(a, b) vcombine_f32(vset_lane_f32(b, vdup_n_f32(a), 1), vset_lane_f32(b, vdup_n_f32(a), 1))
+
+// as for sse2
+#define NEON_KERNEL_1_1(bus, T, ...) \
+static void mix_neon_ ## bus ## _ ## T ## _1_1(void *vdst, const void *vsrc, u32 frames, const f32 *mat, const f32 *d_mat, u32 src_channels, u32 dst_channels) { \
+	bus *dst = vdst; \
+	const T *src = vsrc; \
+	const float32x4_t scale = vdupq_n_f32(SCALE(bus, T)), m = vdupq_n_f32(mat[0]), dm = vdupq_n_f32(d_mat[0]); \
+	u32 i = 0; \
+	for (; i + 4 <= frames; i += 4) { \
+		float32x4_t idx = vcvtq_f32_s32(vaddq_s32(vdupq_n_s32(i), vld1q_s32(neon_step))); \
+		NEON_ACC_ ## bus(dst + i, vmulq_f32(vmulq_f32(neon_load_ ## T(src + i), scale), NEON_RAMP(m, dm, idx))); \
+	} \
+	mix_frames_ ## bus ## _ ## T(dst, src, i, frames, mat, d_mat, 1, 1); \
+}
+#define NEON_KERNEL_2_1(bus, T, ...) \
+static void mix_neon_ ## bus ## _ ## T ## _2_1(void *vdst, const void *vsrc, u32 frames, const f32 *mat, const f32 *d_mat, u32 src_channels, u32 dst_channels) { \
+	bus *dst = vdst; \
+	const T *src = vsrc; \
+	const float32x4_t scale = vdupq_n_f32(SCALE(bus, T)); \
+	const float32x4_t ml = vdupq_n_f32(mat[0]), dml = vdupq_n_f32(d_mat[0]), mr = vdupq_n_f32(mat[1]), dmr = vdupq_n_f32(d_mat[1]); \
+	u32 i = 0; \
+	for (; i + 4 <= frames; i += 4) { \
+		float32x4_t idx = vcvtq_f32_s32(vaddq_s32(vdupq_n_s32(i), vld1q_s32(neon_step))); \
+		float32x4_t s0, s1; \
+		NEON_LOAD_2(T, src + 2*i, s0, s1); \
+		float32x4x2_t lr = vuzpq_f32(s0, s1); \
+		NEON_ACC_ ## bus(dst + i, vaddq_f32(vmulq_f32(vmulq_f32(lr.val[0], scale), NEON_RAMP(ml, dml, idx)), \
+		                                    vmulq_f32(vmulq_f32(lr.val[1], scale), NEON_RAMP(mr, dmr, idx)))); \
+	} \
+	mix_frames_ ## bus ## _ ## T(dst, src, i, frames, mat, d_mat, 2, 1); \
+}
+#define NEON_KERNEL_1_2(bus, T, ...) \
+static void mix_neon_ ## bus ## _ ## T ## _1_2(void *vdst, const void *vsrc, u32 frames, const f32 *mat, const f32 *d_mat, u32 src_channels, u32 dst_channels) { \
+	bus *dst = vdst; \
+	const T *src = vsrc; \
+	const float32x4_t scale = vdupq_n_f32(SCALE(bus, T)), two = vdupq_n_f32(2); \
+	const float32x4_t m = NEON_PAIR(mat[0], mat[1]), dm = NEON_PAIR(d_mat[0], d_mat[1]); \
+	u32 i = 0; \
+	for (; i + 4 <= frames; i += 4) { \
+		float32x4_t i0 = vcvtq_f32_s32(vaddq_s32(vdupq_n_s32(i), vld1q_s32(neon_step_lr))), i1 = vaddq_f32(i0, two); \
+		float32x4_t s0, s1; \
+		NEON_LOAD_1(T, src + i, s0, s1); \
+		NEON_ACC_ ## bus(dst + 2*i,     vmulq_f32(vmulq_f32(s0, scale), NEON_RAMP(m, dm, i0))); \
+		NEON_ACC_ ## bus(dst + 2*i + 4, vmulq_f32(vmulq_f32(s1, scale), NEON_RAMP(m, dm, i1))); \
+	} \
+	mix_frames_ ## bus ## _ ## T(dst, src, i, frames, mat, d_mat, 1, 2); \
+}
+#define NEON_KERNEL_2_2(bus, T, ...) \
+static void mix_neon_ ## bus ## _ ## T ## _2_2(void *vdst, const void *vsrc, u32 frames, const f32 *mat, const f32 *d_mat, u32 src_channels, u32 dst_channels) { \
+	bus *dst = vdst; \
+	const T *src = vsrc; \
+	const float32x4_t scale = vdupq_n_f32(SCALE(bus, T)), two = vdupq_n_f32(2); \
+	const float32x4_t m = NEON_PAIR(mat[0], mat[3]), dm = NEON_PAIR(d_mat[0], d_mat[3]); \
+	const float32x4_t x = NEON_PAIR(mat[2], mat[1]), dx = NEON_PAIR(d_mat[2], d_mat[1]); \
+	u32 i = 0; \
+	for (; i + 4 <= frames; i += 4) { \
+		float32x4_t i0 = vcvtq_f32_s32(vaddq_s32(vdupq_n_s32(i), vld1q_s32(neon_step_lr))), i1 = vaddq_f32(i0, two); \
+		float32x4_t s0, s1; \
+		NEON_LOAD_2(T, src + 2*i, s0, s1); \
+		s0 = vmulq_f32(s0, scale); \
+		s1 = vmulq_f32(s1, scale); \
+		NEON_ACC_ ## bus(dst + 2*i,     vaddq_f32(vmulq_f32(s0, NEON_RAMP(m, dm, i0)), vmulq_f32(NEON_SWAP(s0), NEON_RAMP(x, dx, i0)))); \
+		NEON_ACC_ ## bus(dst + 2*i + 4, vaddq_f32(vmulq_f32(s1, NEON_RAMP(m, dm, i1)), vmulq_f32(NEON_SWAP(s1), NEON_RAMP(x, dx, i1)))); \
+	} \
+	mix_frames_ ## bus ## _ ## T(dst, src, i, frames, mat, d_mat, 2, 2); \
+}
+LAYOUT_KERNELS(1, 1, NEON_KERNEL_1_1)
+LAYOUT_KERNELS(2, 1, NEON_KERNEL_2_1)
+LAYOUT_KERNELS(1, 2, NEON_KERNEL_1_2)
+LAYOUT_KERNELS(2, 2, NEON_KERNEL_2_2)
+#undef NEON_KERNEL_1_1
+#undef NEON_KERNEL_2_1
+#undef NEON_KERNEL_1_2
+#undef NEON_KERNEL_2_2
+#undef NEON_PAIR
+#undef NEON_RAMP
+#undef NEON_SWAP
+#undef NEON_ACC_s32
+#undef NEON_ACC_f32
+#undef NEON_LOAD_1
+#undef NEON_LOAD_2
+
+static void add_neon_s32(void *vdst, const void *vsrc, usz n) {
+	s32 *dst = vdst;
+	const s32 *src = vsrc;
+	usz i = 0;
+	for (; i + 4 <= n; i += 4) vst1q_s32(dst + i, vaddq_s32(vld1q_s32(dst + i), vld1q_s32(src + i)));
+	add_scalar_s32(dst + i, src + i, n - i);
+}
+static void add_neon_f32(void *vdst, const void *vsrc, usz n) {
+	f32 *dst = vdst;
+	const f32 *src = vsrc;
+	usz i = 0;
+	for (; i + 4 <= n; i += 4) vst1q_f32(dst + i, vaddq_f32(vld1q_f32(dst + i), vld1q_f32(src + i)));
+	add_scalar_f32(dst + i, src + i, n - i);
+}
+
+// Output conversion, 8 samples at a time, as for sse2.  vcvtq_s32_f32
+// saturates, where cvtt doesn't
+static inline float32x4_t neon_dither(const f32 *noise, usz lag, usz i) {
+	return vsubq_f32(vld1q_f32(noise + i + lag), vld1q_f32(noise + i));
+}
+// round to nearest, even on ties, like lrintf
+static inline int32x4_t neon_round(float32x4_t x) {
+#ifdef __aarch64__
+	return vcvtnq_s32_f32(x);
+#else
+	// adding 1.5*2²³ leaves the nearest integer in the low bits of the mantissa
+	const float32x4_t magic = vdupq_n_f32(12582912.f);
+	return vcvtq_s32_f32(vsubq_f32(vaddq_f32(x, magic), magic));
+#endif
+}
+#define NEON_LOAD_S16(mix, i) vcombine_s16(vqmovn_s32(vld1q_s32((mix) + (i))), vqmovn_s32(vld1q_s32((mix) + (i) + 4)))
+#define NEON_PACK_U8(a, b) vqmovun_s16(vcombine_s16(vqmovn_s32(a), vqmovn_s32(b)))
+#define NEON_LOAD_F32(mix, i) vminq_f32(vmaxq_f32(vld1q_f32((mix) + (i)), vdupq_n_f32(-1)), vdupq_n_f32(1))
+#define NEON_SCALE(f, pos) vbslq_f32(vcltq_f32(f, vdupq_n_f32(0)), vdupq_n_f32(pos + 1), vdupq_n_f32(pos))
+
+static void convert_neon_s32_u8(void *vdst, const void *vmix, usz n, const f32 *noise, usz lag) {
+	u8 *dst = vdst;
+	const s32 *mix = vmix;
+	const int32x4_t c128 = vdupq_n_s32(128);
+	const float32x4_t scale = vdupq_n_f32(1.f / 256);
+	usz i = 0;
+	if (noise) {
+		for (; i + 8 <= n; i += 8) {
+			int16x8_t s = NEON_LOAD_S16(mix, i);
+			int32x4_t a = neon_round(vaddq_f32(vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(s))), scale), neon_dither(noise, lag, i)));
+			int32x4_t b = neon_round(vaddq_f32(vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(s))), scale), neon_dither(noise, lag, i + 4)));
+			vst1_u8(dst + i, NEON_PACK_U8(vaddq_s32(a, c128), vaddq_s32(b, c128)));
+		}
+	} else {
+		for (; i + 8 <= n; i += 8) {
+			uint16x8_t u = vreinterpretq_u16_s16(veorq_s16(NEON_LOAD_S16(mix, i), vdupq_n_s16(-32768)));
+			vst1_u8(dst + i, vshrn_n_u16(u, 8));
+		}
+	}
+	convert_scalar_s32_u8(dst + i, mix + i, n - i, noise ? noise + i : NULL, lag);
+}
+static void convert_neon_s32_s16(void *vdst, const void *vmix, usz n, const f32 *noise, usz lag) {
+	s16 *dst = vdst;
+	const s32 *mix = vmix;
+	usz i = 0;
+	for (; i + 8 <= n; i += 8) vst1q_s16(dst + i, NEON_LOAD_S16(mix, i));
+	convert_scalar_s32_s16(dst + i, mix + i, n - i, NULL, lag);
+}
+static void convert_neon_s32_s32(void *vdst, const void *vmix, usz n, const f32 *noise, usz lag) {
+	s32 *dst = vdst;
+	const s32 *mix = vmix;
+	usz i = 0;
+	for (; i + 4 <= n; i += 4) vst1q_s32(dst + i, vshll_n_s16(vqmovn_s32(vld1q_s32(mix + i)), 16));
+	convert_scalar_s32_s32(dst + i, mix + i, n - i, NULL, lag);
+}
+static void convert_neon_s32_f32(void *vdst, const void *vmix, usz n, const f32 *noise, usz lag) {
+	f32 *dst = vdst;
+	const s32 *mix = vmix;
+	usz i = 0;
+#ifdef __aarch64__
+	// armv7 can't divide, and multiplying by the reciprocal of 32767 would round differently
+	for (; i + 4 <= n; i += 4) {
+		float32x4_t a = vcvtq_f32_s32(vmovl_s16(vqmovn_s32(vld1q_s32(mix + i))));
+		vst1q_f32(dst + i, vdivq_f32(a, NEON_SCALE(a, 32767)));
+	}
+#endif
+	convert_scalar_s32_f32(dst + i, mix + i, n - i, NULL, lag);
+}
+static void convert_neon_f32_u8(void *vdst, const void *vmix, usz n, const f32 *noise, usz lag) {
+	u8 *dst = vdst;
+	const f32 *mix = vmix;
+	const int32x4_t c128 = vdupq_n_s32(128);
+	usz i = 0;
+	if (noise) {
+		for (; i + 8 <= n; i += 8) {
+			float32x4_t f = NEON_LOAD_F32(mix, i), g = NEON_LOAD_F32(mix, i + 4);
+			int32x4_t a = neon_round(vaddq_f32(vmulq_f32(f, NEON_SCALE(f, 127)), neon_dither(noise, lag, i)));
+			int32x4_t b = neon_round(vaddq_f32(vmulq_f32(g, NEON_SCALE(g, 127)), neon_dither(noise, lag, i + 4)));
+			vst1_u8(dst + i, NEON_PACK_U8(vaddq_s32(a, c128), vaddq_s32(b, c128)));
+		}
+	} else {
+		for (; i + 8 <= n; i += 8) {
+			float32x4_t f = NEON_LOAD_F32(mix, i), g = NEON_LOAD_F32(mix, i + 4);
+			int32x4_t a = vcvtq_s32_f32(vaddq_f32(vdupq_n_f32(128), vmulq_f32(f, NEON_SCALE(f, 127))));
+			int32x4_t b = vcvtq_s32_f32(vaddq_f32(vdupq_n_f32(128), vmulq_f32(g, NEON_SCALE(g, 127))));
+			vst1_u8(dst + i, NEON_PACK_U8(a, b));
+		}
+	}
+	convert_scalar_f32_u8(dst + i, mix + i, n - i, noise ? noise + i : NULL, lag);
+}
+static void convert_neon_f32_s16(void *vdst, const void *vmix, usz n, const f32 *noise, usz lag) {
+	s16 *dst = vdst;
+	const f32 *mix = vmix;
+	usz i = 0;
+	if (noise) {
+		for (; i + 8 <= n; i += 8) {
+			float32x4_t f = NEON_LOAD_F32(mix, i), g = NEON_LOAD_F32(mix, i + 4);
+			int32x4_t a = neon_round(vaddq_f32(vmulq_f32(f, NEON_SCALE(f, 32767)), neon_dither(noise, lag, i)));
+			int32x4_t b = neon_round(vaddq_f32(vmulq_f32(g, NEON_SCALE(g, 32767)), neon_dither(noise, lag, i + 4)));
+			vst1q_s16(dst + i, vcombine_s16(vqmovn_s32(a), vqmovn_s32(b)));
+		}
+	} else {
+		for (; i + 8 <= n; i += 8) {
+			float32x4_t f = NEON_LOAD_F32(mix, i), g = NEON_LOAD_F32(mix, i + 4);
+			int32x4_t a = vcvtq_s32_f32(vmulq_f32(f, NEON_SCALE(f, 32767)));
+			int32x4_t b = vcvtq_s32_f32(vmulq_f32(g, NEON_SCALE(g, 32767)));
+			vst1q_s16(dst + i, vcombine_s16(vqmovn_s32(a), vqmovn_s32(b)));
+		}
+	}
+	convert_scalar_f32_s16(dst + i, mix + i, n - i, noise ? noise + i : NULL, lag);
+}
+static void convert_neon_f32_s32(void *vdst, const void *vmix, usz n, const f32 *noise, usz lag) {
+	s32 *dst = vdst;
+	const f32 *mix = vmix;
+	usz i = 0;
+	for (; i + 4 <= n; i += 4) vst1q_s32(dst + i, vcvtq_s32_f32(vmulq_f32(vld1q_f32(mix + i), vdupq_n_f32(2147483648.f))));
+	convert_scalar_f32_s32(dst + i, mix + i, n - i, NULL, lag);
+}
+static void convert_neon_f32_f32(void *vdst, const void *vmix, usz n, const f32 *noise, usz lag) {
+	convert_scalar_f32_f32(vdst, vmix, n, NULL, lag);
+}
+#undef NEON_LOAD_S16
+#undef NEON_PACK_U8
+#undef NEON_LOAD_F32
+#undef NEON_SCALE
+
+// as for sse2
+#define NEON_LOAD_ABS_s32(mix, i) vabsq_f32(vcvtq_f32_s32(vld1q_s32((mix) + (i))))
+#define NEON_LOAD_ABS_f32(mix, i) vabsq_f32(vld1q_f32((mix) + (i)))
+#define NEON_PEAKS(bus, scale) \
+static void peaks_neon_ ## bus(f32 *peaks, const void *vmix, u32 frames, u32 channels) { \
+	const bus *mix = vmix; \
+	const float32x4_t k = vdupq_n_f32(scale); \
+	u32 i = 0; \
+	if (channels == 1) { \
+		for (; i + 4 <= frames; i += 4) vst1q_f32(peaks + i, vmulq_f32(NEON_LOAD_ABS_ ## bus(mix, i), k)); \
+	} else if (channels == 2) { \
+		for (; i + 4 <= frames; i += 4) { \
+			float32x4x2_t lr = vuzpq_f32(NEON_LOAD_ABS_ ## bus(mix, 2*i), NEON_LOAD_ABS_ ## bus(mix, 2*i + 4)); \
+			vst1q_f32(peaks + i, vmulq_f32(vmaxq_f32(lr.val[1], lr.val[0]), k)); \
+		} \
+	} \
+	peaks_scalar_ ## bus(peaks + i, mix + i * channels, frames - i, channels); \
+}
+NEON_PEAKS(s32, 1.f / 32768)
+NEON_PEAKS(f32, 1.f)
+#undef NEON_PEAKS
+#undef NEON_LOAD_ABS_s32
+#undef NEON_LOAD_ABS_f32
+
+#define NEON_GAIN_s32(mix, i, g) vst1q_s32((mix) + (i), vcvtq_s32_f32(vmulq_f32(vcvtq_f32_s32(vld1q_s32((mix) + (i))), g)))
+#define NEON_GAIN_f32(mix, i, g) vst1q_f32((mix) + (i), vmulq_f32(vld1q_f32((mix) + (i)), g))
+#define NEON_GAIN(bus) \
+static void gain_neon_ ## bus(void *vmix, const f32 *gains, u32 frames, u32 channels) { \
+	bus *mix = vmix; \
+	u32 i = 0; \
+	if (channels == 1) { \
+		for (; i + 4 <= frames; i += 4) NEON_GAIN_ ## bus(mix, i, vld1q_f32(gains + i)); \
+	} else if (channels == 2) { \
+		for (; i + 4 <= frames; i += 4) { \
+			float32x4x2_t g = vzipq_f32(vld1q_f32(gains + i), vld1q_f32(gains + i)); \
+			NEON_GAIN_ ## bus(mix, 2*i,     g.val[0]); \
+			NEON_GAIN_ ## bus(mix, 2*i + 4, g.val[1]); \
+		} \
+	} \
+	gain_scalar_ ## bus(mix + i * channels, gains + i, frames - i, channels); \
+}
+NEON_GAIN(s32)
+NEON_GAIN(f32)
+#undef NEON_GAIN
+#undef NEON_GAIN_s32
+#undef NEON_GAIN_f32
+
+static inline uint32x4_t neon_xorshift(uint32x4_t x) {
+	x = veorq_u32(x, vshlq_n_u32(x, 13));
+	x = veorq_u32(x, vshrq_n_u32(x, 17));
+	return veorq_u32(x, vshlq_n_u32(x, 5));
+}
+static inline float32x4_t neon_noise_of(uint32x4_t x) {
+	return vsubq_f32(vreinterpretq_f32_u32(vorrq_u32(vshrq_n_u32(x, 9), vdupq_n_u32(0x3f800000))), vdupq_n_f32(1.5f));
+}
+static void noise_neon(f32 *noise, usz n, u32 *state) {
+	uint32x4_t x0 = vld1q_u32(state), x1 = vld1q_u32(state + 4);
+	usz i = 0;
+	for (; i + 8 <= n; i += 8) {
+		x0 = neon_xorshift(x0);
+		x1 = neon_xorshift(x1);
+		vst1q_f32(noise + i,     neon_noise_of(x0));
+		vst1q_f32(noise + i + 4, neon_noise_of(x1));
+	}
+	vst1q_u32(state, x0);
+	vst1q_u32(state + 4, x1);
+	noise_scalar(noise + i, n - i, state);
+}
+
+static f32 dot_neon(const f32 *a, const f32 *b, u32 n) {
+	float32x4_t s = vdupq_n_f32(0);
+	for (u32 i = 0; i < n; i += 4) s = vaddq_f32(s, vmulq_f32(vld1q_f32(a + i), vld1q_f32(b + i)));
+	float32x2_t h = vadd_f32(vget_low_f32(s), vget_high_f32(s));
+	return vget_lane_f32(vpadd_f32(h, h), 0);
+}
+
+// as for sse2; armv7 can't divide, and multiplying by the reciprocal would round differently
+static void lerp_neon_1(f32 *dst, const f32 *src, const u32 *idx, const f32 *frac, u32 n, f32 rate) {
+	u32 i = 0;
+#ifdef __aarch64__
+	float32x4_t r = vdupq_n_f32(rate);
+	for (; i + 4 <= n; i += 4) {
+		float32x4x2_t p = vuzpq_f32(vcombine_f32(vld1_f32(src + idx[i]), vld1_f32(src + idx[i + 1])),
+		                            vcombine_f32(vld1_f32(src + idx[i + 2]), vld1_f32(src + idx[i + 3])));
+		vst1q_f32(dst + i, vaddq_f32(p.val[0], vdivq_f32(vmulq_f32(vsubq_f32(p.val[1], p.val[0]), vld1q_f32(frac + i)), r)));
+	}
+#endif
+	lerp_scalar_1(dst + i, src, idx + i, frac + i, n - i, rate);
+}
+static void lerp_neon_2(f32 *dst, const f32 *src, const u32 *idx, const f32 *frac, u32 n, f32 rate) {
+	u32 i = 0;
+#ifdef __aarch64__
+	float32x4_t r = vdupq_n_f32(rate);
+	for (; i + 2 <= n; i += 2) {
+		float32x4_t a = vld1q_f32(src + 2 * idx[i]), b = vld1q_f32(src + 2 * idx[i + 1]);
+		float32x4_t s = vcombine_f32(vget_low_f32(a), vget_low_f32(b)), e = vcombine_f32(vget_high_f32(a), vget_high_f32(b));
+		float32x4_t f = vcombine_f32(vdup_n_f32(frac[i]), vdup_n_f32(frac[i + 1]));
+		vst1q_f32(dst + 2 * i, vaddq_f32(s, vdivq_f32(vmulq_f32(vsubq_f32(e, s), f), r)));
+	}
+#endif
+	lerp_scalar_2(dst + 2 * i, src, idx + i, frac + i, n - i, rate);
+}
+
+static const GaXMixKernels kernels_neon = KERNEL_TABLE(neon);
+#endif //GAX_NEON
+
+const GaXMixKernels *gaX_mix_kernels_select(void) {
+#ifdef GAX_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) return &kernels_avx2;
+	if (__builtin_cpu_supports("sse2")) return &kernels_sse2;
+#elif defined(GAX_NEON)
+	return &kernels_neon;
+#endif
+	return &gaX_mix_kernels_scalar;
+}
+
+/* Mix matrices */
+
+enum {
+	Speaker_FL, Speaker_FR, Speaker_FC, Speaker_LFE,
+	Speaker_BL, Speaker_BR, Speaker_BC, Speaker_SL, Speaker_SR,
+	Speaker_Count,
+};
+
+// the speaker each channel plays on, by channel count, in WAVE order
+static const u8 speaker_layouts[GAX_MAX_CHANNELS][GAX_MAX_CHANNELS] = {
+	{Speaker_FC},
+	{Speaker_FL, Speaker_FR},
+	{Speaker_FL, Speaker_FR, Speaker_FC},
+	{Speaker_FL, Speaker_FR, Speaker_BL, Speaker_BR},
+	{Speaker_FL, Speaker_FR, Speaker_FC, Speaker_BL, Speaker_BR},
+	{Speaker_FL, Speaker_FR, Speaker_FC, Speaker_LFE, Speaker_BL, Speaker_BR},
+	{Speaker_FL, Speaker_FR, Speaker_FC, Speaker_LFE, Speaker_BC, Speaker_SL, Speaker_SR},
+	{Speaker_FL, Speaker_FR, Speaker_FC, Speaker_LFE, Speaker_BL, Speaker_BR, Speaker_SL, Speaker_SR},
+};
+
+// Add gain c, from a source channel on speaker sp, to row.  where[] gives the
+// mixer channel for each speaker, or -1.  Missing speakers fold down onto
+// their neighbours at -3dB (sides and backs stand in for each other at full
+// level); LFE is dropped unless the mixer has one.  Every layout has either
+// the front pair or the centre, so this terminates
+static void route(f32 *row, const s8 *where, u32 sp, f32 c) {
+	const f32 h = 0.70710678f;
+	if (where[sp] >= 0) {
+		row[where[sp]] += c;
+		return;
+	}
+	switch (sp) {
+		case Speaker_FL:
+		case Speaker_FR:
+			route(row, where, Speaker_FC, c * h);
+			break;
+		case Speaker_FC:
+			route(row, where, Speaker_FL, c * h);
+			route(row, where, Speaker_FR, c * h);
+			break;
+		case Speaker_BL:
+			if (where[Speaker_SL] >= 0) route(row, where, Speaker_SL, c);
+			else route(row, where, Speaker_FL, c * h);
+			break;
+		case Speaker_BR:
+			if (where[Speaker_SR] >= 0) route(row, where, Speaker_SR, c);
+			else route(row, where, Speaker_FR, c * h);
+			break;
+		case Speaker_SL:
+			if (where[Speaker_BL] >= 0) route(row, where, Speaker_BL, c);
+			else route(row, where, Speaker_FL, c * h);
+			break;
+		case Speaker_SR:
+			if (where[Speaker_BR] >= 0) route(row, where, Speaker_BR, c);
+			else route(row, where, Speaker_FR, c * h);
+			break;
+		case Speaker_BC:
+			route(row, where, Speaker_BL, c * h);
+			route(row, where, Speaker_BR, c * h);
+			break;
+		case Speaker_LFE:
+		default:
+			break;
+	}
+}
+
+void gaX_mix_matrix(f32 *mat, u32 src_channels, u32 dst_channels, f32 gain, f32 pan) {
+	assert(src_channels && src_channels <= GAX_MAX_CHANNELS);
+	assert(dst_channels && dst_channels <= GAX_MAX_CHANNELS);
+	const u8 *src = speaker_layouts[src_channels - 1];
+	const u8 *dst = speaker_layouts[dst_channels - 1];
+	s8 where[Speaker_Count];
+	memset(where, -1, sizeof(where));
+	for (u32 d = 0; d < dst_channels; d++) where[dst[d]] = d;
+
+	pan = clamp((pan + 1) / 2, 0, 1);
+	f32 l = min((1 - pan) * 2, 1.f);
+	f32 r = min(pan * 2, 1.f);
+
+	for (u32 s = 0; s < src_channels; s++) {
+		f32 *row = mat + s * dst_channels;
+		for (u32 d = 0; d < dst_channels; d++) row[d] = 0;
+		if (src_channels == 1 && where[Speaker_FL] >= 0) {
+			row[where[Speaker_FL]] = row[where[Speaker_FR]] = 1;
+		} else {
+			route(row, where, src[s], 1);
+		}
+
+		for (u32 d = 0; d < dst_channels; d++) {
+			switch (dst[d]) {
+				case Speaker_FL: case Speaker_BL: case Speaker_SL: row[d] *= l; break;
+				case Speaker_FR: case Speaker_BR: case Speaker_SR: row[d] *= r; break;
+			}
+			row[d] *= gain;
+		}
+	}
+}
@@ -4,6 +4,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <limits.h>
 
 /* Thread Functions */
 
@@ -46,6 +47,12 @@ void ga_thread_sleep(u32 ms) {
 void ga_thread_yield(void) {
 	SwitchToThread();
 }
+u64 gaX_time_ns(void) {
+	LARGE_INTEGER t, f;
+	QueryPerformanceCounter(&t);
+	QueryPerformanceFrequency(&f);
+	return (u64)(t.QuadPart / f.QuadPart) * 1000000000 + (u64)(t.QuadPart % f.QuadPart) * 1000000000 / f.QuadPart;
+}
 void ga_thread_destroy(GaThread *thread) {
 	CloseHandle(thread->thread_obj->h);
 	ga_free(thread->thread_obj);
@@ -69,6 +76,21 @@ void ga_mutex_unlock(GaMutex mutex) {
 	LeaveCriticalSection((CRITICAL_SECTION*)mutex.mutex);
 }
 
+ga_result ga_semaphore_create(GaSemaphore *res, u32 count) {
+	res->sem = CreateSemaphore(NULL, count, LONG_MAX, NULL);
+	return res->sem ? GA_OK : GA_ERR_SYS_LIB;
+}
+void ga_semaphore_wait(GaSemaphore sem) {
+	WaitForSingleObject((HANDLE)sem.sem, INFINITE);
+}
+void ga_semaphore_post(GaSemaphore sem) {
+	ReleaseSemaphore((HANDLE)sem.sem, 1, NULL);
+}
+void ga_semaphore_destroy(GaSemaphore sem) {
+	if (!sem.sem) return;
+	CloseHandle((HANDLE)sem.sem);
+}
+
 #elif defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__) || defined(__unix__) || defined(__POSIX__)
 #include <pthread.h>
 #include <sched.h>
@@ -88,6 +110,7 @@ struct GaThreadObj {
 	pthread_t thread;
 	pthread_attr_t attr;
 	ThreadWrapperContext *ctx;
+	bool joined;
 };
 
 void *ga_thread_wrapper(void *context) { ThreadWrapperContext *ctx = context; ctx->res = ctx->func(ctx->context); return NULL; }
@@ -109,6 +132,7 @@ GaThread *ga_thread_create(GaCbThreadFunc thread_func, void *context,
 
 	thread_obj->ctx->func = thread_func;
 	thread_obj->ctx->context = context;
+	thread_obj->joined = false;
 
 	if (pthread_attr_init(&thread_obj->attr) != 0) {
 		ga_err("unable to create pthread attribute object");
@@ -139,6 +163,7 @@ fail:
 }
 void ga_thread_join(GaThread *thread) {
 	pthread_join(thread->thread_obj->thread, 0);
+	thread->thread_obj->joined = true;
 }
 void ga_thread_sleep(u32 ms) {
 	nanosleep(&(struct timespec){.tv_sec = ms / 1000, .tv_nsec = (ms % 1000) * 1000000}, NULL);
@@ -146,9 +171,17 @@ void ga_thread_sleep(u32 ms) {
 void ga_thread_yield(void) {
 	sched_yield();
 }
+u64 gaX_time_ns(void) {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (u64)t.tv_sec * 1000000000 + t.tv_nsec;
+}
 void ga_thread_destroy(GaThread *thread) {
-	pthread_cancel(thread->thread_obj->thread);
-	pthread_join(thread->thread_obj->thread, NULL);
+	// can't cancel (or join) a thread that's already been joined
+	if (!thread->thread_obj->joined) {
+		pthread_cancel(thread->thread_obj->thread);
+		pthread_join(thread->thread_obj->thread, NULL);
+	}
 	pthread_attr_destroy(&thread->thread_obj->attr);
 	ga_free(thread->thread_obj->ctx);
 	ga_free(thread->thread_obj);
@@ -160,6 +193,7 @@ ga_result ga_mutex_create(GaMutex *res) {
 	if (!res->mutex) return GA_ERR_SYS_LIB;
 	if (pthread_mutex_init((pthread_mutex_t*)res->mutex, NULL)) {
 		ga_free(res->mutex);
+		res->mutex = NULL;
 		return GA_ERR_SYS_LIB;
 	}
 	return GA_OK;
@@ -176,6 +210,51 @@ void ga_mutex_unlock(GaMutex mutex) {
 	pthread_mutex_unlock((pthread_mutex_t*)mutex.mutex);
 }
 
+// no sem_init on macos
+typedef struct {
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	u32 count;
+} Semaphore;
+
+ga_result ga_semaphore_create(GaSemaphore *res, u32 count) {
+	Semaphore *sem = ga_alloc(sizeof(Semaphore));
+	if (!sem) return GA_ERR_SYS_MEM;
+	if (pthread_mutex_init(&sem->mutex, NULL)) {
+		ga_free(sem);
+		return GA_ERR_SYS_LIB;
+	}
+	if (pthread_cond_init(&sem->cond, NULL)) {
+		pthread_mutex_destroy(&sem->mutex);
+		ga_free(sem);
+		return GA_ERR_SYS_LIB;
+	}
+	sem->count = count;
+	res->sem = sem;
+	return GA_OK;
+}
+void ga_semaphore_wait(GaSemaphore sem) {
+	Semaphore *s = sem.sem;
+	pthread_mutex_lock(&s->mutex);
+	while (!s->count) pthread_cond_wait(&s->cond, &s->mutex);
+	s->count--;
+	pthread_mutex_unlock(&s->mutex);
+}
+void ga_semaphore_post(GaSemaphore sem) {
+	Semaphore *s = sem.sem;
+	pthread_mutex_lock(&s->mutex);
+	s->count++;
+	pthread_cond_signal(&s->cond);
+	pthread_mutex_unlock(&s->mutex);
+}
+void ga_semaphore_destroy(GaSemaphore sem) {
+	Semaphore *s = sem.sem;
+	if (!s) return;
+	pthread_cond_destroy(&s->cond);
+	pthread_mutex_destroy(&s->mutex);
+	ga_free(s);
+}
+
 #elif (__STDC_VERSION__ >= 201112L) && !defined(__STDC_NO_THREADS__)
 
 _Static_assert(sizeof(ga_result) == sizeof(int), "aliasing is illegal!");
@@ -206,6 +285,11 @@ void ga_thread_sleep(u32 ms) {
 void ga_thread_yield(void) {
 	thrd_sleep(&(struct timespec){.tv_sec = 0, .tv_nsec = 0}, NULL);
 }
+u64 gaX_time_ns(void) {
+	struct timespec t;
+	timespec_get(&t, TIME_UTC); //not monotonic, but it's what there is
+	return (u64)t.tv_sec * 1000000000 + t.tv_nsec;
+}
 void ga_thread_destroy(GaThread *thread) {
 	thrd_detach(thread->thread_obj->t); //pretty much the best we can do
 	ga_free(thread->thread_obj);
@@ -233,6 +317,50 @@ void ga_mutex_destroy(GaMutex mutex) {
 	ga_free(mutex.mutex);
 }
 
+typedef struct {
+	mtx_t mutex;
+	cnd_t cond;
+	u32 count;
+} Semaphore;
+
+ga_result ga_semaphore_create(GaSemaphore *res, u32 count) {
+	Semaphore *sem = ga_alloc(sizeof(Semaphore));
+	if (!sem) return GA_ERR_SYS_MEM;
+	if (mtx_init(&sem->mutex, mtx_plain) != thrd_success) {
+		ga_free(sem);
+		return GA_ERR_SYS_LIB;
+	}
+	if (cnd_init(&sem->cond) != thrd_success) {
+		mtx_destroy(&sem->mutex);
+		ga_free(sem);
+		return GA_ERR_SYS_LIB;
+	}
+	sem->count = count;
+	res->sem = sem;
+	return GA_OK;
+}
+void ga_semaphore_wait(GaSemaphore sem) {
+	Semaphore *s = sem.sem;
+	mtx_lock(&s->mutex);
+	while (!s->count) cnd_wait(&s->cond, &s->mutex);
+	s->count--;
+	mtx_unlock(&s->mutex);
+}
+void ga_semaphore_post(GaSemaphore sem) {
+	Semaphore *s = sem.sem;
+	mtx_lock(&s->mutex);
+	s->count++;
+	cnd_signal(&s->cond);
+	mtx_unlock(&s->mutex);
+}
+void ga_semaphore_destroy(GaSemaphore sem) {
+	Semaphore *s = sem.sem;
+	if (!s) return;
+	cnd_destroy(&s->cond);
+	mtx_destroy(&s->mutex);
+	ga_free(s);
+}
+
 #else
 # error Threading primitives not yet implemented for this platform
 #endif
@@ -257,6 +385,16 @@ static struct {
 	.free = free,
 };
 
+#ifdef GA_CHECK_RT_ALLOC
+// set while the current thread is inside ga_mixer_mix
+static _Thread_local bool in_realtime;
+void gaX_realtime_enter(void) { in_realtime = true; }
+void gaX_realtime_leave(void) { in_realtime = false; }
+# define check_rt_alloc() assert(!in_realtime && "allocation on the mix path")
+#else
+# define check_rt_alloc()
+#endif
+
 static void *alloc_zalloc(usz size) {
 	void *ret = ga_alloc(size);
 	if (!ret) return NULL;
@@ -264,12 +402,15 @@ static void *alloc_zalloc(usz size) {
 }
 
 void *ga_alloc(usz size) {
+	check_rt_alloc();
 	return alloc_callbacks.alloc(size);
 }
 void *ga_zalloc(usz size) {
+	check_rt_alloc();
 	return alloc_callbacks.zalloc(size);
 }
 void *ga_realloc(void *ptr, usz size) {
+	check_rt_alloc();
 	return alloc_callbacks.realloc(ptr, size);
 }
 void ga_free(const void *ptr) {
@@ -289,6 +430,89 @@ ga_result ga_shutdown_systemops(void) {
 	return GA_OK;
 }
 
+/* Pool Functions */
+// Each object is preceded by a header linking it into the free list, so the
+// object itself is left alone while it's pooled
+typedef union GaXPoolHeader {
+	union GaXPoolHeader *next;
+	long double align_ld; //keep the object after it aligned for anything
+	u64 align_u64;
+} GaXPoolHeader;
+
+static void gaX_pool_lock(GaXPool *pool) {
+	while (atomic_flag_test_and_set_explicit(&pool->lock, memory_order_acquire));
+}
+static void gaX_pool_unlock(GaXPool *pool) {
+	atomic_flag_clear_explicit(&pool->lock, memory_order_release);
+}
+
+static GaXPoolHeader *gaX_pool_new(GaXPool *pool) {
+	GaXPoolHeader *h = ga_zalloc(sizeof(GaXPoolHeader) + pool->size);
+	if (h && pool->init && !ga_isok(pool->init(h + 1))) {
+		ga_free(h);
+		h = NULL;
+	}
+	return h;
+}
+
+void *gaX_pool_get(GaXPool *pool) {
+	gaX_pool_lock(pool);
+	GaXPoolHeader *h = pool->free;
+	if (h) {
+		pool->free = h->next;
+		pool->stats.free--;
+	} else pool->stats.misses++;
+	pool->stats.in_use++;
+	pool->stats.peak = max(pool->stats.peak, pool->stats.in_use);
+	gaX_pool_unlock(pool);
+
+	if (!h) {
+		h = gaX_pool_new(pool);
+		if (!h) {
+			gaX_pool_lock(pool);
+			pool->stats.in_use--;
+			gaX_pool_unlock(pool);
+			return NULL;
+		}
+	}
+	return h + 1;
+}
+
+void gaX_pool_put(GaXPool *pool, void *obj) {
+	if (!obj) return;
+	GaXPoolHeader *h = (GaXPoolHeader*)obj - 1;
+	gaX_pool_lock(pool);
+	h->next = pool->free;
+	pool->free = h;
+	pool->stats.free++;
+	pool->stats.in_use--;
+	gaX_pool_unlock(pool);
+}
+
+ga_result gaX_pool_reserve(GaXPool *pool, usz num_free) {
+	gaX_pool_lock(pool);
+	usz have = pool->stats.free;
+	gaX_pool_unlock(pool);
+
+	for (; have < num_free; have++) {
+		GaXPoolHeader *h = gaX_pool_new(pool);
+		if (!h) return GA_ERR_SYS_MEM;
+		gaX_pool_lock(pool);
+		h->next = pool->free;
+		pool->free = h;
+		pool->stats.free++;
+		gaX_pool_unlock(pool);
+	}
+	return GA_OK;
+}
+
+GaPoolStats gaX_pool_stats(GaXPool *pool) {
+	gaX_pool_lock(pool);
+	GaPoolStats ret = pool->stats;
+	gaX_pool_unlock(pool);
+	return ret;
+}
+
 char *gaX_strdup(const char *s) {
 	usz l = strlen(s);
 	char *ret = ga_alloc(1+l);
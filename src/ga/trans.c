@@ -2,21 +2,61 @@
 #include <gorilla/ga_internal.h>
 
 #include <stdio.h>
+#include <math.h>
 
 #include <string.h>
 
-//todo higher-quality bicubic algorithm?
-
 // https://ccrma.stanford.edu/~jos/resample/resample.pdf
 
 enum { WINDOWSIZE = 2 };
 
+// Polyphase sinc filter banks (see ga_trans_resample_sinc) have a row of
+// taps for each of up to MAX_PHASES evenly spaced fractional positions
+// between source frames; positions in between interpolate the rows
+// either side.  Downsampling lowers the cutoff, and widens the filter to
+// keep its steepness, up to MAX_TAPS
+enum { MAX_PHASES = 256, MAX_TAPS = 256 };
+
+// A filter bank: nphases + 1 rows of taps coefficients, the last row being
+// the first moved along a frame.  Each depends only on the (reduced) rates
+// and the quality, so there's one of each in the process, shared by every
+// state resampling that way.  Once the last of them is torn down, it stays
+// cached, so setting up and tearing down in turn (as ga_sound_convert does,
+// once per sound) doesn't build it again each time; up to MAX_IDLE_BANKS
+// are kept, the least recently used going first, until
+// ga_trans_resample_trim.  The cache (most recently used first), the
+// reference counts and num_idle are guarded by gaX_resample_banks_lock
+enum { MAX_IDLE_BANKS = 8 };
+typedef struct GaXResampleBank {
+	struct GaXResampleBank *next;
+	u32 refs;
+	u32 srate, drate;
+	GaResampleQuality quality;
+	u32 taps, nphases;
+	GaXCbMixDot dot;
+	f32 coefs[];
+} GaXResampleBank;
+
+static GaXResampleBank *gaX_resample_banks;
+static u32 gaX_resample_banks_num_idle;
+static atomic_flag gaX_resample_banks_lock = ATOMIC_FLAG_INIT;
+
 struct GaResamplingState {
-	u32 win_start;
+	u32 win_start; //linear: which frame of the window is newest; sinc: oldest frame of the history
 	s32 diff;
 	const u32 srate, drate;
 	const u32 nch;
 	GaSampleFormat sample_fmt;
+	const GaResampleQuality quality;
+
+	// sinc only: the filter bank; the last taps source frames for each
+	// channel, stored twice over so that they can be read straight through
+	// from any frame; and the row for the current position
+	GaXResampleBank *bank;
+	f32 *history;
+	f32 *row;
+	// linear, f32, mono or stereo: the interpolation kernel
+	GaXCbMixLerp lerp;
 
 	// flexible array
 	union {
@@ -124,21 +164,367 @@ void ga_trans_resample_point(GaResamplingState *rs, void *dst, usz dlen, void *s
 	rs->diff = diff; \
 }
 linear_resampler(u8,  s16)
-linear_resampler(s16, s32)
+linear_resampler(s16, s64) // s32 would overflow multiplying by diff when drate is large
 linear_resampler(s32, s64)
 linear_resampler(f32, f32)
 #undef linear_resampler
 
+// The same, for mono and stereo, without a branch per frame.  Output k
+// lies at diff/drate of the way from source frame used - 2 to used - 1,
+// where used frames have been read by then (frames -2 and -1 being the
+// window); both move on by srate/drate each frame.  How many outputs the
+// source lasts for is worked out up front, and those not reaching back
+// into the window are interpolated a block at a time, straight from src;
+// a block's positions are stepped in four interleaved chains, each moving
+// by 4*srate/drate, so no step waits on the one before.  The results are
+// exactly those of the generic version
+enum { LINEAR_BLOCK = 64 };
+// a / d, truncated, as integer division gives it but cheaper: a double
+// holds a exactly when |a| < 2^53, and then its rounded quotient can't
+// cross an integer.  s32 samples can go beyond that, and divide as usual
+static inline s64 gaX_quot_f64(s64 a, s64 d) { return (s64)((f64)a / d); }
+static inline s64 gaX_quot_s64(s64 a, s64 d) { return a / d; }
+#define LINEAR_STEP(used, diff) do { \
+	used += q; \
+	diff += r; \
+	u32 wrap = diff >= drate; \
+	used += wrap; \
+	diff -= drate & -wrap; \
+} while (0)
+#define LINEAR_BLOCK_INT(T, U, NCH, QUOT) \
+	for (u32 i = 0; i < b; i++) { \
+		const T *f = block + idx[i] * NCH; \
+		for (u32 c = 0; c < NCH; c++) { \
+			U s = f[c]; \
+			U ds = f[NCH + c] - s; \
+			*dst++ = s + QUOT(ds * (s32)frac[i], (s32)drate); \
+		} \
+	}
+#define LINEAR_BLOCK_u8(NCH) LINEAR_BLOCK_INT(u8, s16, NCH, gaX_quot_f64)
+#define LINEAR_BLOCK_s16(NCH) LINEAR_BLOCK_INT(s16, s64, NCH, gaX_quot_f64)
+#define LINEAR_BLOCK_s32(NCH) LINEAR_BLOCK_INT(s32, s64, NCH, gaX_quot_s64)
+#define LINEAR_BLOCK_f32(NCH) { \
+	f32 ffrac[LINEAR_BLOCK]; \
+	for (u32 i = 0; i < b; i++) ffrac[i] = frac[i]; \
+	rs->lerp(dst, block, idx, ffrac, b, drate); \
+	dst += b * NCH; \
+}
+#define linear_resampler_n(T, U, NCH) static void gaX_resample_linear_ ## T ## _ ## NCH(GaResamplingState *rs, T *dst, usz dlen, T *src, usz slen) { \
+	u32 srate = rs->srate; \
+	u32 drate = rs->drate; \
+	u32 q = srate / drate, r = srate % drate; \
+	T *window = rs->window ## T; \
+	u32 win_start = rs->win_start; \
+	T older[NCH], newer[NCH]; \
+	for (u32 c = 0; c < NCH; c++) { \
+		older[c] = window[c * WINDOWSIZE + (win_start ^ 1)]; \
+		newer[c] = window[c * WINDOWSIZE + win_start]; \
+	} \
+	usz used = (u32)rs->diff / drate; \
+	u32 diff = (u32)rs->diff % drate; \
+ \
+	for (; dlen && used < 2 && used <= slen; dlen--) { \
+		for (u32 c = 0; c < NCH; c++) { \
+			U s = used ? newer[c] : older[c]; \
+			U ds = (used ? src[c] : newer[c]) - s; \
+			*dst++ = s + ds * (s32)diff / (s32)drate; \
+		} \
+		LINEAR_STEP(used, diff); \
+	} \
+ \
+	usz n = 0; \
+	if (used <= slen) n = min(dlen, (usz)(((u64)(slen - used + 1) * drate - diff + srate - 1) / srate)); \
+	u32 q4 = 4ull * srate / drate, r4 = 4ull * srate % drate; \
+	while (n) { \
+		u32 b = min(n, LINEAR_BLOCK); \
+		u32 idx[LINEAR_BLOCK + 4], frac[LINEAR_BLOCK + 4]; \
+		const T *block = src + (used - 2) * NCH; \
+		usz first = used; \
+		u32 lu[4], ld[4]; \
+		for (u32 j = 0; j < 4; j++) { \
+			lu[j] = used - first; \
+			ld[j] = diff; \
+			LINEAR_STEP(used, diff); \
+		} \
+		for (u32 i = 0; i <= b; i += 4) { \
+			for (u32 j = 0; j < 4; j++) { \
+				idx[i + j] = lu[j]; \
+				frac[i + j] = ld[j]; \
+				ld[j] += r4; \
+				u32 wrap = ld[j] >= drate; \
+				lu[j] += q4 + wrap; \
+				ld[j] -= drate & -wrap; \
+			} \
+		} \
+		LINEAR_BLOCK_ ## T(NCH) \
+		used = first + idx[b]; \
+		diff = frac[b]; \
+		n -= b; \
+	} \
+ \
+	usz consumed = min(used, slen); \
+	for (u32 c = 0; c < NCH; c++) { \
+		if (consumed >= 2) older[c] = src[(consumed - 2) * NCH + c]; \
+		else if (consumed) older[c] = newer[c]; \
+		if (consumed) newer[c] = src[(consumed - 1) * NCH + c]; \
+		window[c * WINDOWSIZE] = newer[c]; \
+		window[c * WINDOWSIZE + 1] = older[c]; \
+	} \
+	rs->win_start = 0; \
+	rs->diff = diff + (used - consumed) * drate; \
+}
+#define linear_resampler_12(T, U) linear_resampler_n(T, U, 1) linear_resampler_n(T, U, 2)
+linear_resampler_12(u8,  s16)
+linear_resampler_12(s16, s64)
+linear_resampler_12(s32, s64)
+linear_resampler_12(f32, f32)
+#undef linear_resampler_12
+#undef linear_resampler_n
+#undef LINEAR_BLOCK_INT
+#undef LINEAR_BLOCK_u8
+#undef LINEAR_BLOCK_s16
+#undef LINEAR_BLOCK_s32
+#undef LINEAR_BLOCK_f32
+#undef LINEAR_STEP
+
+#define LINEAR_CASE(T) \
+	if (rs->nch == 1) return gaX_resample_linear_ ## T ## _1(rs, dst, dlen, src, slen); \
+	if (rs->nch == 2) return gaX_resample_linear_ ## T ## _2(rs, dst, dlen, src, slen); \
+	return ga_trans_resample_linear_ ## T(rs, dst, dlen, src, slen);
 void ga_trans_resample_linear(GaResamplingState *rs, void *dst, usz dlen, void *src, usz slen) {
 	switch (rs->sample_fmt) {
-		case GaSampleFormat_U8:  return ga_trans_resample_linear_u8(rs, dst, dlen, src, slen);
-		case GaSampleFormat_S16: return ga_trans_resample_linear_s16(rs, dst, dlen, src, slen);
-		case GaSampleFormat_S32: return ga_trans_resample_linear_s32(rs, dst, dlen, src, slen);
-		case GaSampleFormat_F32: return ga_trans_resample_linear_f32(rs, dst, dlen, src, slen);
+		case GaSampleFormat_U8:  LINEAR_CASE(u8)
+		case GaSampleFormat_S16: LINEAR_CASE(s16)
+		case GaSampleFormat_S32: LINEAR_CASE(s32)
+		case GaSampleFormat_F32: LINEAR_CASE(f32)
+		default: assert(0);
+	}
+}
+#undef LINEAR_CASE
+
+
+static inline f32 load_u8(u8 x) { return ga_trans_f32_of_u8(x); }
+static inline f32 load_s16(s16 x) { return ga_trans_f32_of_s16(x); }
+static inline f32 load_s32(s32 x) { return ga_trans_f32_of_s32(x); }
+static inline f32 load_f32(f32 x) { return x; }
+// filtering can overshoot full scale; only floats can hold that
+static inline u8 store_u8(f32 x) { return ga_trans_u8_of_f32(clamp(x, -1.f, 1.f)); }
+static inline s16 store_s16(f32 x) { return ga_trans_s16_of_f32(clamp(x, -1.f, 1.f)); }
+static inline s32 store_s32(f32 x) { return ga_trans_s32_of_f32(clamp(x, -1.f, 0x7fffff80 / 2147483648.f)); }
+static inline f32 store_f32(f32 x) { return x; }
+
+// the filter for a position diff/drate of the way between the two frames
+// in the middle of the history
+static const f32 *gaX_resample_row(GaResamplingState *rs, u32 diff) {
+	u64 p = (u64)diff * rs->bank->nphases;
+	u32 taps = rs->bank->taps;
+	const f32 *r = rs->bank->coefs + p / rs->drate * taps;
+	if (!(p % rs->drate)) return r;
+	f32 frac = (f32)(p % rs->drate) / rs->drate;
+	for (u32 j = 0; j < taps; j++) rs->row[j] = r[j] + frac * (r[j + taps] - r[j]);
+	return rs->row;
+}
+
+// The same scheme as the linear resampler, with a longer window: each
+// output frame is interpolated between the two frames in the middle of the
+// last taps source frames, so it comes out taps/2 - 1 frames later
+#define sinc_resampler(T) void ga_trans_resample_sinc_ ## T(GaResamplingState *rs, T *dst, usz dlen, T *src, usz slen) { \
+	s32 srate = rs->srate; \
+	s32 drate = rs->drate; \
+	s32 diff = rs->diff; \
+	u32 taps = rs->bank->taps; \
+	GaXCbMixDot dot = rs->bank->dot; \
+	u32 oldest = rs->win_start; \
+	u32 nch = rs->nch; \
+ \
+	while (true) { \
+		if (diff >= drate) { \
+			if (!slen) break; \
+			f32 *history = rs->history; \
+			for (u32 c = 0; c < nch; c++) { \
+				history[oldest] = history[oldest + taps] = load_ ## T(*src++); \
+				history += 2 * taps; \
+			} \
+			oldest = oldest + 1 == taps ? 0 : oldest + 1; \
+ \
+			diff -= drate; \
+			slen--; \
+		} else { \
+			if (!dlen) break; \
+			const f32 *row = gaX_resample_row(rs, diff); \
+			const f32 *history = rs->history + oldest; \
+			for (u32 c = 0; c < nch; c++) { \
+				*dst++ = store_ ## T(dot(row, history, taps)); \
+				history += 2 * taps; \
+			} \
+ \
+			diff += srate; \
+			dlen--; \
+		} \
+	} \
+ \
+	rs->win_start = oldest; \
+	rs->diff = diff; \
+}
+sinc_resampler(u8)
+sinc_resampler(s16)
+sinc_resampler(s32)
+sinc_resampler(f32)
+#undef sinc_resampler
+
+void ga_trans_resample_sinc(GaResamplingState *rs, void *dst, usz dlen, void *src, usz slen) {
+	assert(rs->bank);
+	switch (rs->sample_fmt) {
+		case GaSampleFormat_U8:  return ga_trans_resample_sinc_u8(rs, dst, dlen, src, slen);
+		case GaSampleFormat_S16: return ga_trans_resample_sinc_s16(rs, dst, dlen, src, slen);
+		case GaSampleFormat_S32: return ga_trans_resample_sinc_s32(rs, dst, dlen, src, slen);
+		case GaSampleFormat_F32: return ga_trans_resample_sinc_f32(rs, dst, dlen, src, slen);
 		default: assert(0);
 	}
 }
 
+void ga_trans_resample(GaResamplingState *rs, void *dst, usz dlen, void *src, usz slen) {
+	if (rs->quality == GaResampleQuality_Linear) ga_trans_resample_linear(rs, dst, dlen, src, slen);
+	else ga_trans_resample_sinc(rs, dst, dlen, src, slen);
+}
+
+// output frame k lands at source frame k*srate/drate - latency: the linear
+// resampler's window ends at the newest frame, the sinc's taps/2 - 1 later
+u32 ga_trans_resample_latency(GaResamplingState *rs) {
+	return 2 + (rs->bank ? rs->bank->taps / 2 - 1 : 0);
+}
+
+// zeroth-order modified Bessel function of the first kind, for the Kaiser window
+static f64 bessel_i0(f64 x) {
+	f64 sum = 1, term = 1;
+	for (u32 k = 1; term > sum * 1e-12; k++) {
+		term *= (x / (2 * k)) * (x / (2 * k));
+		sum += term;
+	}
+	return sum;
+}
+
+// Kaiser-windowed sinc lowpass, cutting off at the lower of the two Nyquist
+// rates, less the width of its transition band, and sampled at taps points
+// for each phase.  Each row is scaled to unity gain at DC, so nothing
+// drifts by the interpolation
+static GaXResampleBank *gaX_resample_bank_create(u32 srate, u32 drate, GaResampleQuality quality) {
+	// taps, and stopband attenuation (dB) for the Kaiser window
+	static const struct { u32 taps; f64 atten; } qualities[] = {
+		[GaResampleQuality_Low]    = {16, 60},
+		[GaResampleQuality_Medium] = {32, 80},
+		[GaResampleQuality_High]   = {64, 100},
+	};
+	f64 atten = qualities[quality].atten;
+	f64 scale = srate > drate ? (f64)drate / srate : 1;
+	u32 taps = min(MAX_TAPS, (u32)ceil(qualities[quality].taps / scale / 4) * 4);
+	u32 nphases = min(drate, MAX_PHASES);
+	f64 width = (atten - 7.95) / (14.36 * taps);
+	f64 cutoff = max(0.5 * scale - width / 2, 0.05 * scale);
+	f64 beta = 0.1102 * (atten - 8.7);
+
+	GaXResampleBank *bank = ga_alloc(sizeof(GaXResampleBank) + (nphases + 1) * taps * sizeof(f32));
+	if (!bank) return NULL;
+	*bank = (GaXResampleBank){.refs = 1, .srate = srate, .drate = drate, .quality = quality, .taps = taps, .nphases = nphases, .dot = gaX_mix_kernels_select()->dot};
+
+	const f64 pi = 3.14159265358979323846, half = taps / 2.;
+	f64 norm = bessel_i0(beta);
+	for (u32 r = 0; r <= nphases; r++) {
+		f32 *row = bank->coefs + r * taps;
+		f64 sum = 0;
+		for (u32 j = 0; j < taps; j++) {
+			// distance from tap j to the position, which is r/nphases of
+			// the way from the frame before the middle of the window
+			f64 x = half - 1 + (f64)r / nphases - j;
+			f64 u = x / half;
+			f64 w = u * u < 1 ? bessel_i0(beta * sqrt(1 - u * u)) / norm : 0;
+			f64 t = 2 * cutoff * x;
+			f64 h = 2 * cutoff * (t == 0 ? 1 : sin(pi * t) / (pi * t)) * w;
+			row[j] = h;
+			sum += h;
+		}
+		for (u32 j = 0; j < taps; j++) row[j] /= sum;
+	}
+	return bank;
+}
+
+static void gaX_resample_banks_lock_acquire(void) {
+	while (atomic_flag_test_and_set_explicit(&gaX_resample_banks_lock, memory_order_acquire));
+}
+static void gaX_resample_banks_lock_release(void) {
+	atomic_flag_clear_explicit(&gaX_resample_banks_lock, memory_order_release);
+}
+
+// take a reference to the cached bank for these rates, if there is one,
+// and move it to the front
+static GaXResampleBank *gaX_resample_bank_find(u32 srate, u32 drate, GaResampleQuality quality) {
+	for (GaXResampleBank **p = &gaX_resample_banks; *p; p = &(*p)->next) {
+		GaXResampleBank *b = *p;
+		if (b->srate == srate && b->drate == drate && b->quality == quality) {
+			if (!b->refs++) gaX_resample_banks_num_idle--;
+			*p = b->next;
+			b->next = gaX_resample_banks;
+			gaX_resample_banks = b;
+			return b;
+		}
+	}
+	return NULL;
+}
+
+// unlink the least recently used bank nothing refers to, if there's any
+static GaXResampleBank *gaX_resample_bank_evict(void) {
+	GaXResampleBank **victim = NULL;
+	for (GaXResampleBank **p = &gaX_resample_banks; *p; p = &(*p)->next) {
+		if (!(*p)->refs) victim = p;
+	}
+	if (!victim) return NULL;
+	GaXResampleBank *ret = *victim;
+	*victim = ret->next;
+	gaX_resample_banks_num_idle--;
+	return ret;
+}
+
+// the cached bank for these rates, building it if there isn't one yet
+static GaXResampleBank *gaX_resample_bank_acquire(u32 srate, u32 drate, GaResampleQuality quality) {
+	gaX_resample_banks_lock_acquire();
+	GaXResampleBank *ret = gaX_resample_bank_find(srate, drate, quality);
+	gaX_resample_banks_lock_release();
+	if (ret) return ret;
+
+	// built outside the lock, which is only ever held briefly; if another
+	// thread got there first meanwhile, theirs wins
+	GaXResampleBank *bank = gaX_resample_bank_create(srate, drate, quality);
+	if (!bank) return NULL;
+	gaX_resample_banks_lock_acquire();
+	ret = gaX_resample_bank_find(srate, drate, quality);
+	if (!ret) {
+		bank->next = gaX_resample_banks;
+		gaX_resample_banks = ret = bank;
+		bank = NULL;
+	}
+	gaX_resample_banks_lock_release();
+	ga_free(bank);
+	return ret;
+}
+
+static void gaX_resample_bank_release(GaXResampleBank *bank) {
+	if (!bank) return;
+	GaXResampleBank *evicted = NULL;
+	gaX_resample_banks_lock_acquire();
+	if (!--bank->refs && ++gaX_resample_banks_num_idle > MAX_IDLE_BANKS) evicted = gaX_resample_bank_evict();
+	gaX_resample_banks_lock_release();
+	ga_free(evicted);
+}
+
+void ga_trans_resample_trim(void) {
+	while (true) {
+		gaX_resample_banks_lock_acquire();
+		GaXResampleBank *bank = gaX_resample_bank_evict();
+		gaX_resample_banks_lock_release();
+		if (!bank) break;
+		ga_free(bank);
+	}
+}
 
 // I want to get out frames.  How many frames should I put in?
 usz ga_trans_resample_howmany(GaResamplingState *rs, usz out) {
@@ -146,14 +532,42 @@ usz ga_trans_resample_howmany(GaResamplingState *rs, usz out) {
 }
 
 GaResamplingState *ga_trans_resample_setup(u32 drate, GaFormat fmt) {
-	u32 nch = fmt.num_channels;
-	GaResamplingState *ret = ga_alloc(sizeof(GaResamplingState) + WINDOWSIZE * ga_format_frame_size(fmt));
-	if (!ret) return NULL;
+	return ga_trans_resample_setup_ext(drate, fmt, GaResampleQuality_Linear);
+}
+
+GaResamplingState *ga_trans_resample_setup_ext(u32 drate, GaFormat fmt, GaResampleQuality quality) {
+	if (quality > GaResampleQuality_High) return NULL;
 
+	u32 nch = fmt.num_channels;
 	u32 srate = fmt.frame_rate;
 	u32 g = igcd(drate, srate);
-	memcpy(ret, &(GaResamplingState){.drate=drate/g, .srate=srate/g, .nch=nch, .sample_fmt = fmt.sample_fmt}, sizeof(GaResamplingState));
+	drate /= g;
+	srate /= g;
+
+	GaXResampleBank *bank = NULL;
+	if (quality != GaResampleQuality_Linear) {
+		bank = gaX_resample_bank_acquire(srate, drate, quality);
+		if (!bank) return NULL;
+	}
+
+	u32 taps = bank ? bank->taps : 0;
+	usz window_size = (WINDOWSIZE * ga_format_frame_size(fmt) + 15) & ~(usz)15;
+	usz history_size = (2 * nch + 1) * taps * sizeof(f32);
+	GaResamplingState *ret = ga_zalloc(sizeof(GaResamplingState) + window_size + history_size);
+	if (!ret) {
+		gaX_resample_bank_release(bank);
+		return NULL;
+	}
+	memcpy(ret, &(GaResamplingState){.drate=drate, .srate=srate, .nch=nch, .sample_fmt = fmt.sample_fmt, .quality = quality, .bank = bank}, sizeof(GaResamplingState));
+	if (bank) {
+		ret->history = (f32*)((char*)(ret + 1) + window_size);
+		ret->row = ret->history + 2 * nch * taps;
+	}
+	if (fmt.sample_fmt == GaSampleFormat_F32 && (nch == 1 || nch == 2)) ret->lerp = gaX_mix_kernels_select()->lerp[nch - 1];
 	return ret;
 }
 
-void ga_trans_resample_teardown(GaResamplingState *rs) { ga_free(rs); }
+void ga_trans_resample_teardown(GaResamplingState *rs) {
+	gaX_resample_bank_release(rs->bank);
+	ga_free(rs);
+}
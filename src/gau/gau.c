@@ -23,6 +23,8 @@ static ga_result mix_thread(void *context) {
 
 	if (ga_device_class(ctx->device) == GaDeviceClass_AsyncPush) {
 		while (!ctx->kill_threads) {
+			// nothing to play: sleep until there is, rather than queueing silence
+			ga_mixer_wait(ctx->mixer);
 			u32 num_to_queue;
 			ga_result res;
 			for (u32 failure_count = 0; failure_count < 5 && !ga_isok(res = ga_device_check(ctx->device, &num_to_queue)); failure_count++) {
@@ -227,6 +229,7 @@ GaDevice *gau_manager_device(GauManager *mgr) {
 void gau_manager_destroy(GauManager *mgr) {
 	if (mgr->thread_policy == GauThreadPolicy_Multi) {
 		mgr->kill_threads = true;
+		ga_mixer_wake(mgr->mixer);
 		ga_thread_join(mgr->stream_thread);
 		ga_thread_join(mgr->mix_thread);
 		ga_thread_destroy(mgr->stream_thread);
@@ -323,6 +326,14 @@ GaSound *gau_load_sound_file(const char *fname, GauAudioType format) {
 	return ret;
 }
 
+GaSound *gau_load_sound_file_ext(const char *fname, GauAudioType format, GaFormat to) {
+	GaSound *loaded = gau_load_sound_file(fname, format);
+	if (!loaded) return NULL;
+	GaSound *ret = ga_sound_convert(loaded, to, GaResampleQuality_High);
+	ga_sound_release(loaded);
+	return ret;
+}
+
 GaHandle *gau_create_handle_sound_ext(GauManager *mgr, GaSound *sound,
                                       GaHandleGroup *group,
                                       GaCbHandleFinish callback, void *context,
@@ -54,6 +54,17 @@ static usz read(GaSampleSourceContext *ctx, void *dst, usz num_frames, GaCbOnSee
 	}
 	return total_read;
 }
+// only up to the trigger frame; read does the looping
+static usz skip_silence(GaSampleSourceContext *ctx, usz num_frames) {
+	GaSampleSource *ss = ctx->inner_src;
+	if (ctx->loop_enable) {
+		usz pos, trigger_frame;
+		if (!ga_isok(ga_sample_source_tell(ss, &pos, &trigger_frame))) return 0;
+		if (ctx->trigger_frame >= 0) trigger_frame = (usz)ctx->trigger_frame;
+		if (pos <= trigger_frame) num_frames = min(num_frames, trigger_frame - pos);
+	}
+	return ga_sample_source_skip_silence(ss, num_frames);
+}
 static bool end(GaSampleSourceContext *ctx) {
 	return ga_sample_source_end(ctx->inner_src);
 }
@@ -110,6 +121,7 @@ GauSampleSourceLoop *gau_sample_source_create_loop(GaSampleSource *src) {
 		.seek = seek,
 		.tell = tell,
 		.close = close,
+		.skip_silence = skip_silence,
 		.context = ctx,
 		.threadsafe = true,
 		.format = ga_sample_source_format(src),
@@ -39,6 +39,7 @@ struct GaSampleSourceContext {
 	GaDataSource *data_src;
 	bool end_of_samples;
 	GaFormat format;
+	bool vorbis_order; //channel mapping family 1
 	OggOpusFile *ogg_file;
 	GaMutex ogg_mutex;
 };
@@ -53,6 +54,7 @@ static usz ss_read(GaSampleSourceContext *ctx, void *odst, usz num_frames,
 		do {
 			int i = op_read_float(ctx->ogg_file, dst, left, NULL);
 			if (i > 0) {
+				if (ctx->vorbis_order) vorbis_reorder_channels(dst, i, ctx->format.num_channels);
 				ret += i;
 				dst += i * ctx->format.num_channels;
 				left -= i * ctx->format.num_channels;
@@ -137,7 +139,9 @@ GaSampleSource *gau_sample_source_create_opus(GaDataSource *data) {
 	m.format.num_channels = op_head(ctx->ogg_file, 0)->channel_count;
 	m.format.frame_rate = 48000;
 	ctx->format = m.format;
-	bool is_valid_ogg = m.format.num_channels <= 2;
+	ctx->vorbis_order = op_head(ctx->ogg_file, 0)->mapping_family == 1;
+	// beyond 8 channels, there's no telling which is which
+	bool is_valid_ogg = m.format.num_channels <= 8;
 	if (!is_valid_ogg) {
 		op_free(ctx->ogg_file);
 		goto fail;
@@ -69,7 +69,7 @@ static usz ss_read(GaSampleSourceContext *ctx, void *odst, usz num_frames,
 
 			for (u32 i = 0; i < samples_read; ++i) {
 				for (s32 channel = 0; channel < ctx->ogg_info->channels; ++channel) {
-					*dst++ = samples[channel][i];
+					*dst++ = samples[vorbis_channel_index(ctx->ogg_info->channels, channel)][i];
 				}
 			}
 		}
@@ -148,7 +148,8 @@ GaSampleSource *gau_sample_source_create_vorbis(GaDataSource *data) {
 	if (ov_open_callbacks(&ctx->data_src, &ctx->ogg_file, 0, 0, ogg_callbacks) != 0) goto fail;
 	ctx->ogg_info = ov_info(&ctx->ogg_file, -1);
 	if (seekable) ov_pcm_seek(&ctx->ogg_file, 0); /* Seek fixes some poorly-formatted OGGs. */
-	bool is_valid_ogg = ctx->ogg_info->channels <= 2;
+	// beyond 8 channels, there's no telling which is which
+	bool is_valid_ogg = ctx->ogg_info->channels <= 8;
 	if (!is_valid_ogg) {
 		ov_clear(&ctx->ogg_file);
 		goto fail;
@@ -183,6 +184,7 @@ struct GaSampleSourceContext {
 static usz ss_read(GaSampleSourceContext *ctx, void *dst, usz num_frames, GaCbOnSeek onseek, void *seek_ctx) {
 	int ret = stb_vorbis_get_samples_float_interleaved(ctx->vorb, ctx->vorb->channels, dst, num_frames * ctx->vorb->channels);
 	if (ret < 0) return 0;
+	vorbis_reorder_channels(dst, ret, ctx->vorb->channels);
 	return ret;
 }
 
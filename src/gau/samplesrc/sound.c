@@ -7,10 +7,15 @@ struct GaSampleSourceContext {
 	GaSound *sound;
 	u32 frame_size;
 	usz num_frames;
-	GaMutex pos_mutex;
+	GaMutex pos_mutex; //kept while the context is pooled
 	usz pos;
 };
 
+static ga_result init(void *ctx) {
+	return ga_mutex_create(&((GaSampleSourceContext*)ctx)->pos_mutex);
+}
+static GaXPool pool = GAX_POOL_INIT(GaSampleSourceContext, init);
+
 static usz read(GaSampleSourceContext *ctx, void *dst, usz num_frames, GaCbOnSeek onseek, void *seek_ctx) {
 	ga_mutex_lock(ctx->pos_mutex);
 	usz pos = ctx->pos;
@@ -42,14 +47,12 @@ static ga_result tell(GaSampleSourceContext *ctx, usz *pos, usz *total) {
 }
 static void close(GaSampleSourceContext *ctx) {
 	ga_sound_release(ctx->sound);
-	ga_mutex_destroy(ctx->pos_mutex);
-	ga_free(ctx);
+	gaX_pool_put(&pool, ctx);
 }
 
 GaSampleSource *gau_sample_source_create_sound(GaSound *sound) {
-	GaSampleSourceContext *ctx = ga_alloc(sizeof(GaSampleSourceContext));
+	GaSampleSourceContext *ctx = gaX_pool_get(&pool);
 	if (!ctx) return NULL;
-	if (!ga_isok(ga_mutex_create(&ctx->pos_mutex))) goto fail;
 
 	GaSampleSourceCreationMinutiae m = {
 		.read = read,
@@ -69,12 +72,18 @@ GaSampleSource *gau_sample_source_create_sound(GaSound *sound) {
 	ctx->pos = 0;
 
 	GaSampleSource *ret = ga_sample_source_create(&m);
-	if (!ret) goto fail;
+	if (!ret) {
+		gaX_pool_put(&pool, ctx);
+		return NULL;
+	}
 	ga_sound_acquire(sound);
 	return ret;
+}
+
+GaPoolStats gau_sound_pool_stats(void) {
+	return gaX_pool_stats(&pool);
+}
 
-fail:
-	if (ctx) ga_mutex_destroy(ctx->pos_mutex);
-	ga_free(ctx);
-	return NULL;
+ga_result gau_sound_pool_reserve(usz num_free) {
+	return gaX_pool_reserve(&pool, num_free);
 }
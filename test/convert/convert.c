@@ -0,0 +1,134 @@
+// Checks ga_sound_convert at every quality: that the result covers the
+// same length of time as the original, and that a tone comes out at the
+// same level and close to the same place.  The filters' delay is taken out
+// to the nearest output frame, so a tone may be up to half of one early or
+// late; what's left over, once the tone has been fitted, is what each
+// quality adds.
+#include "gorilla/ga.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const double pi = 3.14159265358979323846;
+static const char *qualities[] = {"linear", "low", "medium", "high"};
+// most any output sample may be off from the fitted tone, at each quality,
+// on top of a step of the output format
+static const double tolerance[] = {0.02, 0.005, 0.002, 0.002};
+
+static unsigned checked, failed;
+static void check(int ok, const char *what, unsigned from, unsigned to, int q) {
+	checked++;
+	if (ok) return;
+	failed++;
+	printf("%u->%u, %s: %s\n", from, to, q < 0 ? "-" : qualities[q], what);
+}
+
+// amplitude 0.5, and a different frequency for each channel
+static double freq(unsigned c) {
+	return 440 + 110 * c;
+}
+static float tone(unsigned c, double t) {
+	return 0.5f * (float)sin(2 * pi * freq(c) * t);
+}
+
+// the most storing a sample in the format can take off it
+static double step(GaSampleFormat fmt) {
+	return fmt == GaSampleFormat_U8 ? 1 / 127. : fmt == GaSampleFormat_S16 ? 1 / 32767. : 0;
+}
+
+static float load(const void *data, size_t k, GaSampleFormat fmt) {
+	switch (fmt) {
+		case GaSampleFormat_U8:  return ga_trans_f32_of_u8(((const ga_uint8*)data)[k]);
+		case GaSampleFormat_S16: return ga_trans_f32_of_s16(((const ga_sint16*)data)[k]);
+		case GaSampleFormat_S32: return ga_trans_f32_of_s32(((const ga_sint32*)data)[k]);
+		case GaSampleFormat_F32: return ((const float*)data)[k];
+		default: abort();
+	}
+}
+
+// frames of the tone, in f32
+static GaSound *make_tone(unsigned rate, unsigned nch, size_t frames) {
+	float *data = malloc(frames * nch * sizeof(float) + 1);
+	for (size_t i = 0; i < frames; i++) {
+		for (unsigned c = 0; c < nch; c++) data[i * nch + c] = tone(c, (double)i / rate);
+	}
+	GaMemory *mem = ga_memory_create(data, frames * nch * sizeof(float));
+	free(data);
+	GaSound *ret = ga_sound_create(mem, (GaFormat){.frame_rate = rate, .num_channels = nch, .sample_fmt = GaSampleFormat_F32});
+	ga_memory_release(mem);
+	return ret;
+}
+
+// convert a second of tone, and fit a sine at the tone's frequency to each
+// channel, away from the ends, where the filter runs off the sound
+static void check_tone(unsigned from, unsigned to, unsigned nch_from, unsigned nch_to, GaSampleFormat fmt) {
+	GaSound *snd = make_tone(from, nch_from, from);
+	for (int q = GaResampleQuality_Linear; q <= GaResampleQuality_High; q++) {
+		GaFormat f = {.frame_rate = to, .num_channels = nch_to, .sample_fmt = fmt};
+		GaSound *out = ga_sound_convert(snd, f, q);
+		check(out != NULL, "failed", from, to, q);
+		if (!out) continue;
+		check(ga_sound_num_frames(out) == to, "wrong length", from, to, q);
+		GaFormat got = ga_sound_format(out);
+		check(got.frame_rate == to && got.num_channels == nch_to && got.sample_fmt == fmt, "wrong format", from, to, q);
+
+		const void *data = ga_sound_data(out);
+		double tol = tolerance[q] + step(fmt);
+		size_t first = to / 20, last = to - to / 20;
+		for (unsigned c = 0; c < nch_to; c++) {
+			// one source channel goes to every output channel
+			double w = 2 * pi * freq(nch_from == 1 ? 0 : c) / to;
+			// least squares for x[i] ~ a sin(w i) + b cos(w i)
+			double ss = 0, sc = 0, cc = 0, xs = 0, xc = 0;
+			for (size_t i = first; i < last; i++) {
+				double x = load(data, i * nch_to + c, fmt), si = sin(w * i), ci = cos(w * i);
+				ss += si * si, sc += si * ci, cc += ci * ci, xs += x * si, xc += x * ci;
+			}
+			double det = ss * cc - sc * sc;
+			double a = (xs * cc - xc * sc) / det, b = (xc * ss - xs * sc) / det;
+			double err = 0;
+			for (size_t i = first; i < last; i++) {
+				err = fmax(err, fabs(load(data, i * nch_to + c, fmt) - a * sin(w * i) - b * cos(w * i)));
+			}
+			double level = hypot(a, b), delay = -atan2(b, a) / w; // in output frames
+			check(fabs(level - 0.5) <= tol, "wrong level", from, to, q);
+			check(fabs(delay) <= 0.5 + 1e-3, "out of place", from, to, q);
+			check(err <= tol, "distorted", from, to, q);
+			if (fabs(level - 0.5) > tol || fabs(delay) > 0.5 + 1e-3 || err > tol) {
+				printf("  channel %u: level %g, delay %g frames, off by up to %g\n", c, level, delay, err);
+			}
+		}
+		ga_sound_release(out);
+	}
+	ga_sound_release(snd);
+}
+
+int main(void) {
+	check_tone(44100, 48000, 1, 1, GaSampleFormat_F32);
+	check_tone(44100, 48000, 1, 2, GaSampleFormat_S16);
+	check_tone(48000, 8000, 2, 2, GaSampleFormat_F32);
+	check_tone(8000, 192000, 1, 1, GaSampleFormat_S32);
+	check_tone(22050, 44100, 2, 2, GaSampleFormat_U8);
+
+	// a single frame still lasts as long as it did
+	GaSound *one = make_tone(22050, 1, 1);
+	for (int q = GaResampleQuality_Linear; q <= GaResampleQuality_High; q++) {
+		GaSound *out = ga_sound_convert(one, (GaFormat){.frame_rate = 48000, .num_channels = 1, .sample_fmt = GaSampleFormat_F32}, q);
+		check(out && ga_sound_num_frames(out) == 3, "one frame: wrong length", 22050, 48000, q);
+		if (out) ga_sound_release(out);
+	}
+
+	// nothing to convert gives the same sound back; nothing to convert to, none
+	GaSound *same = ga_sound_convert(one, ga_sound_format(one), GaResampleQuality_High);
+	check(same == one, "same format: not the same sound", 22050, 22050, -1);
+	if (same) ga_sound_release(same);
+	check(!ga_sound_convert(one, (GaFormat){.frame_rate = 48000, .num_channels = 1, .sample_fmt = GaSampleFormat_F32}, GaResampleQuality_High + 1), "bad quality: converted anyway", 22050, 48000, -1);
+	check(!ga_sound_convert(one, (GaFormat){.frame_rate = 0, .num_channels = 1, .sample_fmt = GaSampleFormat_F32}, GaResampleQuality_Linear), "no rate: converted anyway", 22050, 0, -1);
+	ga_sound_release(one);
+
+	ga_trans_resample_trim();
+	printf("%u checks, %u failed\n", checked, failed);
+	return failed != 0;
+}
@@ -0,0 +1,201 @@
+// Checks every vectorized kernel set the running cpu supports against the
+// scalar reference kernels.  They're meant to be bit-identical (see the top
+// of mix.c), so any difference at all is a failure.  Inputs stay small
+// enough that no s32 product overflows, since NEON saturates where the
+// reference wraps.
+#include "../../src/ga/mix.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+enum { MAX_FRAMES = 67 }; // not a multiple of any vector width, to cover the tails
+
+static u32 rng = 0x12345678;
+static u32 rand_u32(void) {
+	return rng = xorshift32(rng);
+}
+// uniform in [lo, hi)
+static f32 rand_f32(f32 lo, f32 hi) {
+	return lo + (hi - lo) * (rand_u32() >> 8) / 16777216.f;
+}
+
+// n samples of the given format, at up to full scale
+static void fill(void *buf, GaSampleFormat fmt, usz n) {
+	for (usz i = 0; i < n; i++) {
+		switch (fmt) {
+			case GaSampleFormat_U8:  ((u8*)buf)[i] = rand_u32(); break;
+			case GaSampleFormat_S16: ((s16*)buf)[i] = rand_u32(); break;
+			case GaSampleFormat_S32: ((s32*)buf)[i] = rand_u32(); break;
+			case GaSampleFormat_F32: ((f32*)buf)[i] = rand_f32(-1, 1); break;
+			default: abort();
+		}
+	}
+}
+
+// n samples of a mix bus, at up to 'scale' times full scale
+static void fill_bus(void *buf, u32 bus, usz n, f32 scale) {
+	for (usz i = 0; i < n; i++) {
+		f32 x = rand_f32(-scale, scale);
+		if (bus) ((f32*)buf)[i] = x;
+		else ((s32*)buf)[i] = (s32)(x * 32768);
+	}
+}
+
+static const char *isa;
+static u32 checked, failed;
+static void check(bool same, const char *what, int a, int b, int c) {
+	checked++;
+	if (same) return;
+	failed++;
+	printf("%s: %s [%d][%d][%d] differs from scalar\n", isa, what, a, b, c);
+}
+
+static const GaSampleFormat formats[4] = {GaSampleFormat_U8, GaSampleFormat_S16, GaSampleFormat_S32, GaSampleFormat_F32};
+
+// the channel counts of each layout, and some pair that goes through the generic kernel
+#define LAYOUT_CHANNELS(s, d, ...) [GaXMixLayout_ ## s ## _ ## d] = {s, d},
+static const u32 layouts[GaXMixLayout_Generic + 1][2] = {
+	GAX_MIX_LAYOUTS(LAYOUT_CHANNELS, _)
+	[GaXMixLayout_Generic] = {3, 5},
+};
+#undef LAYOUT_CHANNELS
+
+static void check_mix(const GaXMixKernels *k) {
+	// room for the resamplers to move through up to two source frames per frame
+	static u8 src[(2 * MAX_FRAMES + 4) * GAX_MAX_CHANNELS * 4];
+	static u8 want[MAX_FRAMES * GAX_MAX_CHANNELS * 4], got[sizeof want];
+	f32 mat[GAX_MAX_CHANNELS * GAX_MAX_CHANNELS], d_mat[GAX_MAX_CHANNELS * GAX_MAX_CHANNELS];
+	const GaXMixKernels *ref = &gaX_mix_kernels_scalar;
+	for (u32 bus = 0; bus < 2; bus++) for (u32 fmt = 0; fmt < 4; fmt++) for (u32 l = 0; l <= GaXMixLayout_Generic; l++) {
+		u32 nsrc = layouts[l][0], ndst = layouts[l][1];
+		for (u32 frames = 1; frames <= MAX_FRAMES; frames += 11) {
+			fill(src, formats[fmt], (frames + 2) * nsrc);
+			fill_bus(want, bus, frames * ndst, 1);
+			memcpy(got, want, sizeof want);
+			for (u32 m = 0; m < nsrc * ndst; m++) {
+				mat[m] = rand_f32(0, 1);
+				d_mat[m] = rand_f32(-1, 1) / frames;
+			}
+			ref->mix[bus][fmt][l](want, src, frames, mat, d_mat, nsrc, ndst);
+			k->mix[bus][fmt][l](got, src, frames, mat, d_mat, nsrc, ndst);
+			check(!memcmp(want, got, sizeof want), "mix", bus, fmt, l);
+
+			f64 step = rand_f32(0.25f, 1.75f), d_step = rand_f32(-0.25f, 0.25f) / frames, pos = rand_f32(0, 1);
+			fill_bus(want, bus, frames * ndst, 1);
+			memcpy(got, want, sizeof want);
+			fill(src, formats[fmt], (2 * MAX_FRAMES + 4) * nsrc);
+			ref->resample[bus][fmt][l](want, src, frames, pos, step, d_step, mat, d_mat, nsrc, ndst);
+			k->resample[bus][fmt][l](got, src, frames, pos, step, d_step, mat, d_mat, nsrc, ndst);
+			check(!memcmp(want, got, sizeof want), "resample", bus, fmt, l);
+		}
+	}
+}
+
+static void check_bus(const GaXMixKernels *k) {
+	enum { N = MAX_FRAMES * GAX_MAX_CHANNELS };
+	static u8 mix[N * 4], want[N * 4], got[N * 4];
+	static f32 noise[N + GAX_MAX_CHANNELS], fwant[N], fgot[N];
+	const GaXMixKernels *ref = &gaX_mix_kernels_scalar;
+	for (u32 bus = 0; bus < 2; bus++) {
+		for (u32 n = 1; n <= N; n += 37) {
+			fill_bus(mix, bus, n, 1);
+			fill_bus(want, bus, n, 1);
+			memcpy(got, want, sizeof want);
+			ref->add[bus](want, mix, n);
+			k->add[bus](got, mix, n);
+			check(!memcmp(want, got, sizeof want), "add", bus, n, 0);
+
+			// past full scale, to be clipped
+			fill_bus(mix, bus, n, 1.5f);
+			for (u32 lag = 1; lag <= 2; lag++) {
+				for (usz i = 0; i < n + lag; i++) noise[i] = rand_f32(-0.5f, 0.5f);
+				for (u32 fmt = 0; fmt < 4; fmt++) {
+					for (u32 dither = 0; dither < 2; dither++) {
+						memset(want, 0, sizeof want);
+						memset(got, 0, sizeof got);
+						ref->convert[bus][fmt](want, mix, n, dither ? noise : NULL, lag);
+						k->convert[bus][fmt](got, mix, n, dither ? noise : NULL, lag);
+						check(!memcmp(want, got, sizeof want), "convert", bus, fmt, dither * 2 + lag);
+					}
+				}
+			}
+		}
+		for (u32 channels = 1; channels <= GAX_MAX_CHANNELS; channels++) {
+			for (u32 frames = 1; frames <= MAX_FRAMES; frames += 11) {
+				fill_bus(mix, bus, frames * channels, 1.5f);
+				memset(fwant, 0, sizeof fwant);
+				memset(fgot, 0, sizeof fgot);
+				ref->peaks[bus](fwant, mix, frames, channels);
+				k->peaks[bus](fgot, mix, frames, channels);
+				check(!memcmp(fwant, fgot, sizeof fwant), "peaks", bus, channels, frames);
+
+				for (u32 i = 0; i < frames; i++) fwant[i] = rand_f32(0, 1);
+				memcpy(want, mix, sizeof mix);
+				memcpy(got, mix, sizeof mix);
+				ref->gain[bus](want, fwant, frames, channels);
+				k->gain[bus](got, fwant, frames, channels);
+				check(!memcmp(want, got, sizeof want), "gain", bus, channels, frames);
+			}
+		}
+	}
+
+	for (u32 n = 1; n <= N; n += 37) {
+		u32 swant[GAX_NOISE_LANES], sgot[GAX_NOISE_LANES];
+		for (u32 i = 0; i < GAX_NOISE_LANES; i++) swant[i] = sgot[i] = rand_u32() | 1;
+		ref->noise(fwant, n, swant);
+		k->noise(fgot, n, sgot);
+		check(!memcmp(fwant, fgot, n * sizeof(f32)) && !memcmp(swant, sgot, sizeof swant), "noise", n, 0, 0);
+	}
+}
+
+static void check_filters(const GaXMixKernels *k) {
+	enum { N = 256 };
+	static f32 a[N], b[N], want[2 * N], got[2 * N];
+	static u32 idx[N];
+	const GaXMixKernels *ref = &gaX_mix_kernels_scalar;
+	for (u32 n = 4; n <= N; n += 4) {
+		for (u32 i = 0; i < n; i++) a[i] = rand_f32(-1, 1), b[i] = rand_f32(-1, 1);
+		f32 x = ref->dot(a, b, n), y = k->dot(a, b, n);
+		check(!memcmp(&x, &y, sizeof x), "dot", n, 0, 0);
+	}
+	for (u32 c = 0; c < 2; c++) {
+		for (u32 n = 1; n <= N / 4; n += 7) {
+			u32 rate = 1 + rand_u32() % 48000;
+			for (u32 i = 0; i < n; i++) {
+				idx[i] = rand_u32() % (N / 2 - 1);
+				b[i] = rand_u32() % rate;
+			}
+			for (u32 i = 0; i < N; i++) a[i] = rand_f32(-1, 1);
+			memset(want, 0, sizeof want);
+			memset(got, 0, sizeof got);
+			ref->lerp[c](want, a, idx, b, n, rate);
+			k->lerp[c](got, a, idx, b, n, rate);
+			check(!memcmp(want, got, sizeof want), "lerp", c + 1, n, 0);
+		}
+	}
+}
+
+static void check_kernels(const GaXMixKernels *k) {
+	isa = k->name;
+	u32 before = failed;
+	checked = 0;
+	check_mix(k);
+	check_bus(k);
+	check_filters(k);
+	printf("%s: %u checks, %u differ from scalar\n", isa, checked, failed - before);
+}
+
+int main(void) {
+#ifdef GAX_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("sse2")) check_kernels(&kernels_sse2);
+	else printf("sse2: not supported here\n");
+	if (__builtin_cpu_supports("avx2")) check_kernels(&kernels_avx2);
+	else printf("avx2: not supported here\n");
+#elif defined(GAX_NEON)
+	check_kernels(&kernels_neon);
+#else
+	printf("no vectorized kernels on this cpu\n");
+#endif
+	return failed != 0;
+}
@@ -0,0 +1,136 @@
+// Checks the mono and stereo linear resamplers against the generic one they
+// specialize, then times both.  They're meant to give exactly the same
+// output and leave exactly the same state behind (see trans.c), so any
+// difference at all is a failure.  The timings are frames of output per
+// second, converting 44.1kHz to 48kHz.
+#include "../../src/ga/trans.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+enum {
+	SRC_FRAMES = 1 << 16,
+	MAX_CALL = 700,        // most frames either side of one call
+	BENCH_FRAMES = 48000,  // output frames per call, when timing
+	BENCH_CALLS = 200,
+};
+
+typedef void (*GaXResampleFunc)(GaResamplingState *rs, void *dst, usz dlen, void *src, usz slen);
+
+static const GaSampleFormat formats[4] = {GaSampleFormat_U8, GaSampleFormat_S16, GaSampleFormat_S32, GaSampleFormat_F32};
+static const char *names[4] = {"u8", "s16", "s32", "f32"};
+static const GaXResampleFunc generic[4] = {
+	(GaXResampleFunc)ga_trans_resample_linear_u8,
+	(GaXResampleFunc)ga_trans_resample_linear_s16,
+	(GaXResampleFunc)ga_trans_resample_linear_s32,
+	(GaXResampleFunc)ga_trans_resample_linear_f32,
+};
+
+// source rate, destination rate
+static const u32 rates[][2] = {
+	{44100, 48000}, {48000, 44100}, {22050, 48000}, {8000, 48000},
+	{48000, 8000}, {44100, 44100}, {32000, 48001}, {96000, 22050},
+};
+
+static u8 src[SRC_FRAMES * 2 * 4];
+static u8 want[BENCH_FRAMES * 2 * 4], got[sizeof want];
+
+static u32 rng = 0x12345678;
+static u32 rand_u32(void) {
+	rng ^= rng << 13;
+	rng ^= rng >> 17;
+	rng ^= rng << 5;
+	return rng;
+}
+
+// n samples of the given format, at up to full scale
+static void fill(void *buf, GaSampleFormat fmt, usz n) {
+	for (usz i = 0; i < n; i++) {
+		switch (fmt) {
+			case GaSampleFormat_U8:  ((u8*)buf)[i] = rand_u32(); break;
+			case GaSampleFormat_S16: ((s16*)buf)[i] = rand_u32(); break;
+			case GaSampleFormat_S32: ((s32*)buf)[i] = rand_u32(); break;
+			case GaSampleFormat_F32: ((f32*)buf)[i] = (s32)rand_u32() / 2147483648.f; break;
+			default: abort();
+		}
+	}
+}
+
+// the window's newer and older frame for each channel, in that order.  The
+// specialized resamplers leave the newer frame first; the generic one
+// leaves it wherever win_start says
+static void window(GaResamplingState *rs, usz sample_size, u8 *out) {
+	const u8 *w = rs->windowu8; // all the windows start at the same place
+	for (u32 c = 0; c < rs->nch; c++) {
+		for (u32 k = 0; k < 2; k++) {
+			memcpy(out, w + (c * WINDOWSIZE + (rs->win_start ^ k)) * sample_size, sample_size);
+			out += sample_size;
+		}
+	}
+}
+
+static u32 checked, failed;
+static void check(bool same, const char *what, u32 fmt, u32 nch, u32 r) {
+	checked++;
+	if (same) return;
+	failed++;
+	printf("%s x%u, %u->%u: %s differs from generic\n", names[fmt], nch, rates[r][0], rates[r][1], what);
+}
+
+// feed both resamplers the same run of calls, with the source and output
+// lengths chosen independently so each side runs out first about half the
+// time, and compare what they write and where they're left
+static void check_exact(u32 fmt, u32 nch, u32 r) {
+	GaFormat f = {.frame_rate = rates[r][0], .num_channels = nch, .sample_fmt = formats[fmt]};
+	usz frame_size = ga_format_frame_size(f), sample_size = frame_size / nch;
+	GaResamplingState *a = ga_trans_resample_setup(rates[r][1], f);
+	GaResamplingState *b = ga_trans_resample_setup(rates[r][1], f);
+	fill(src, formats[fmt], SRC_FRAMES * nch);
+	u8 wa[2 * 2 * 4], wb[sizeof wa];
+	for (usz s = 0; s + MAX_CALL <= SRC_FRAMES;) {
+		usz dlen = rand_u32() % MAX_CALL, slen = rand_u32() % MAX_CALL;
+		// what's past the output either writes must be left alone
+		memset(want, 0xa5, (dlen + 1) * frame_size);
+		memset(got, 0xa5, (dlen + 1) * frame_size);
+		generic[fmt](a, want, dlen, src + s * frame_size, slen);
+		ga_trans_resample_linear(b, got, dlen, src + s * frame_size, slen);
+		check(!memcmp(want, got, (dlen + 1) * frame_size), "output", fmt, nch, r);
+		check(a->diff == b->diff, "position", fmt, nch, r);
+		window(a, sample_size, wa);
+		window(b, sample_size, wb);
+		check(!memcmp(wa, wb, 2 * nch * sample_size), "window", fmt, nch, r);
+		if (a->diff != b->diff) break;
+		s += slen;
+	}
+	ga_trans_resample_teardown(a);
+	ga_trans_resample_teardown(b);
+}
+
+// output frames per second, in millions
+static f64 bench(GaXResampleFunc resample, GaFormat f) {
+	GaResamplingState *rs = ga_trans_resample_setup(48000, f);
+	clock_t t = clock();
+	for (u32 i = 0; i < BENCH_CALLS; i++) {
+		usz slen = ga_trans_resample_howmany(rs, BENCH_FRAMES);
+		resample(rs, got, BENCH_FRAMES, src, slen);
+	}
+	t = clock() - t;
+	ga_trans_resample_teardown(rs);
+	return (f64)BENCH_CALLS * BENCH_FRAMES / t * CLOCKS_PER_SEC / 1e6;
+}
+
+int main(void) {
+	for (u32 fmt = 0; fmt < 4; fmt++) for (u32 nch = 1; nch <= 2; nch++) {
+		for (u32 r = 0; r < sizeof rates / sizeof *rates; r++) check_exact(fmt, nch, r);
+	}
+	printf("%u checks, %u differ from generic\n", checked, failed);
+
+	for (u32 fmt = 0; fmt < 4; fmt++) for (u32 nch = 1; nch <= 2; nch++) {
+		GaFormat f = {.frame_rate = 44100, .num_channels = nch, .sample_fmt = formats[fmt]};
+		fill(src, formats[fmt], SRC_FRAMES * nch);
+		f64 g = bench(generic[fmt], f), s = bench(ga_trans_resample_linear, f);
+		printf("%s x%u: generic %6.1f Mframes/s, specialized %6.1f Mframes/s\n", names[fmt], nch, g, s);
+	}
+	return failed != 0;
+}